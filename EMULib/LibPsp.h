@@ -21,6 +21,9 @@
 
 #define SND_BUFSIZE     256    /* Size of a wave buffer      */
 
+extern int SoundBuffers;       /* Wave buffers queued, 2..8    */
+extern int SoundBufSize;       /* Samples per wave buffer      */
+
 /** InitAudio() **********************************************/
 /** Initialize sound. Returns rate (Hz) on success, else 0. **/
 /** Rate=0 to skip initialization (will be silent).         **/
@@ -48,6 +51,25 @@ void ResumeSound(void);
 void TrashAudio(void);
 
 #if defined(FMSX) && defined(ALTSOUND)
+#define SND_PSG    0           /* Sound chips, for GetChipRate() */
+#define SND_SCC    1
+#define SND_OPLL   2
+#define SND_AUDIO  3
+#define SND_CHIPS  4
+
+#define SND_FAST     0         /* SoundQuality: EMULib chips  */
+#define SND_STANDARD 1         /* emu2149/2212/2413 and fmopl */
+#define SND_HIGH     2         /* Same, at native chip rates  */
+
+#define SND_FMOPL    0         /* AudioEngine: MAME fmopl     */
+#define SND_EMU8950  1         /* emu8950 and emuadpcm        */
+
+extern int SoundStats;         /* 1: measure chip render speed */
+extern int SoundGain[SND_CHIPS]; /* Chip volume, %; 0 = muted  */
+extern int SoundQuality;       /* SND_FAST, SND_STANDARD, ...  */
+extern int AudioEngine;        /* MSX-AUDIO emulator, SND_FMOPL... */
+extern int SynthRate;          /* SND_STANDARD chip rate, Hz; 0 = output */
+
 void WritePSG(int R,int V);
 void WriteSNG(int R,int V);
 void Write2212(int R,int V);
@@ -55,6 +77,24 @@ void WriteOPLL(int R,int V);
 void WriteAUDIO(int R,int V);
 int  ReadAUDIO(int R);
 int  ReadPSG(int R);
+
+/** SoundClock() *********************************************/
+/** Return emulated CPU cycles elapsed. Used to timestamp   **/
+/** sound register writes. Provided by the emulator.        **/
+/*************************************************************/
+unsigned int SoundClock(void);
+
+/** GetChipRate() ********************************************/
+/** Return samples/second a sound chip renders at, or 0 if  **/
+/** not measured (SoundStats=0, chip unused).               **/
+/*************************************************************/
+unsigned int GetChipRate(int Chip);
+
+/** GetSoundLoad() *******************************************/
+/** Return the share of real time the audio thread spends   **/
+/** mixing, in 0.1% units, or 0 if not measured.            **/
+/*************************************************************/
+unsigned int GetSoundLoad(void);
 #endif
 
 int FileExistsArchived(const char *path);
@@ -13,16 +13,28 @@
 /**     changes to this file.                               **/
 /*************************************************************/
 
+#include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #if defined(FMSX) && defined(ALTSOUND)
 #include "fmopl.h"
 #include "emu2149.h"
 #include "emu2212.h"
 #include "emu2413.h"
+/* emu8950 slot and channel types clash with fmopl's */
+#define OPL_SLOT Y8950_SLOT
+#define OPL_CH   Y8950_CH
+#include "emu8950.h"
+#undef OPL_SLOT
+#undef OPL_CH
 #endif
 
+#include <pspthreadman.h>
+#include <psprtc.h>
+
 #include "pl_snd.h"
+#include "pl_capture.h"
 #include "Sound.h"
 
 static void MixAudio(short *buffer, unsigned int length);
@@ -33,16 +45,136 @@ static void AudioCallback(pl_snd_sample *buf, unsigned int samples, void *userda
 
 static OPLL   *opll;
 static FM_OPL *fm_opl;
+static OPL    *y8950;  /* emu8950, for AudioEngine=SND_EMU8950 */
 static PSG    *psg;
 static SCC    *scc;
 
 int Use2413 = 0;     /* MSX-MUSIC emulation (1=enable)  */
 int Use8950 = 0;     /* MSX-AUDIO emulation (1=enable)  */
 
-float FactorPSG  = 3.00;  /* Volume percentage of PSG        */
-float FactorSCC  = 3.00;  /* Volume percentage of SCC        */
-float Factor2413 = 3.00;  /* Volume percentage of MSX-MUSIC  */
-float Factor8950 = 2.25;  /* Volume percentage of MSX-AUDIO  */
+int SoundGain[SND_CHIPS] =  /* Chip volume, % of default (0=mute) */
+{ 100, 100, 100, 100 };
+int SoundQuality = SND_STANDARD; /* SND_FAST, SND_STANDARD, ... */
+int AudioEngine = SND_FMOPL; /* MSX-AUDIO: SND_FMOPL, SND_EMU8950 */
+int SynthRate = 0;   /* SND_STANDARD chip rate, Hz (0=output) */
+
+extern int MasterVolume;  /* EMULib volume, Sound.c */
+
+/** Mixer ****************************************************/
+/** Chips are summed with Q15 gains in a 32-bit accumulator,**/
+/** then run through a DC-blocking high-pass filter and a   **/
+/** look-ahead limiter instead of being hard clipped. The   **/
+/** limiter delays output by LIM_CHUNK samples, so it sees  **/
+/** each peak coming and lowers the gain before it.         **/
+/*************************************************************/
+#define LIM_CHUNK     32            /* Look-ahead, samples    */
+#define LIM_THRESHOLD 29491         /* Peak limit, 90% of max */
+#define LIM_RELEASE   128           /* Gain recovery/chunk, Q15 */
+
+static const int ChipGain[SND_CHIPS] = /* Default gains, Q15  */
+{ 3*32768, 3*32768, 3*32768, 9*8192 }; /* 3.0,3.0,3.0,2.25    */
+
+static int MixBuf[SND_BUFSIZE];     /* Mixed chips, Q11       */
+static int DCIn,DCOut;              /* High-pass state, Q4    */
+static int LimBuf[2][LIM_CHUNK];    /* Delayed, incoming chunk */
+static int LimPeak[2];              /* Peaks of both chunks   */
+static int LimCur,LimPos;           /* Incoming chunk, fill   */
+static int LimGain;                 /* Current gain, Q15      */
+
+/** Sound register queue *************************************/
+/** Register writes are timestamped in emulated CPU cycles  **/
+/** and queued by the emulation thread, then applied by the **/
+/** audio thread at the matching sample. Single producer,   **/
+/** single consumer: only the emulator moves SndHead, only  **/
+/** the audio thread moves SndTail.                         **/
+/*************************************************************/
+#define SNDQ_SIZE  4096             /* Queue size, power of 2 */
+#define SNDQ_MASK  (SNDQ_SIZE-1)
+
+/* Keeps the compiler from moving entry accesses past a head */
+/* or tail update. The PSP has a single core, so no hardware */
+/* barrier is needed.                                        */
+#define SNDQ_BARRIER() __asm__ __volatile__("":::"memory")
+
+#define SND_RESET  SND_CHIPS        /* Reset all chips        */
+
+typedef struct
+{
+  unsigned int Time;                /* CPU cycle of the write */
+  unsigned char Chip;               /* SND_PSG, SND_SCC, ...  */
+  unsigned char Value;              /* Value written          */
+  unsigned short Reg;               /* Register or address    */
+} SndEvent;
+
+static SndEvent SndQueue[SNDQ_SIZE];
+static volatile unsigned int SndHead = 0; /* Next free entry  */
+static volatile unsigned int SndTail = 0; /* Next entry to do */
+static volatile int SndPaused = 0;  /* 1: audio thread idle   */
+
+static unsigned int SndNow;         /* Audio clock, CPU cycles */
+static unsigned int SndFrac;        /* Fraction of a cycle    */
+static unsigned int SndStep;        /* Cycles/sample, 16.16   */
+static int SndLatency;              /* Audio behind emu, cycles */
+
+/** Register shadows *****************************************/
+/** The last value written to each chip register, kept by   **/
+/** the emulation thread. Chips created by InitAudio() are  **/
+/** loaded from these, so sound state survives a restart.   **/
+/*************************************************************/
+static unsigned char PSGRegs[32];   /* PSG registers, for reads */
+static unsigned char SCCRegs[2][256]; /* 9800h, B800h pages   */
+static unsigned char SCCUsed;       /* SCCRegs[] pages in use */
+static unsigned char OPLLRegs[64];
+static unsigned char AudioRegs[256];
+static unsigned char AudioLatch;
+static UINT8 *AudioRAM = 0;         /* Y8950 RAM across restarts */
+
+/** Per-chip block rendering *********************************/
+/** Each chip renders a run of samples into its own buffer, **/
+/** then the buffers are mixed in one pass. SoundStats=1    **/
+/** times each chip, as samples/second in ChipRate[].       **/
+/*************************************************************/
+static INT16 ChipBuf[SND_CHIPS][SND_BUFSIZE];
+static u64 ChipTicks[SND_CHIPS];    /* Time spent rendering   */
+static unsigned int ChipCount = 0;  /* Samples measured so far */
+static unsigned int ChipRate[SND_CHIPS];
+static u64 MixTicks;                /* Time spent in MixAudio() */
+static unsigned int SoundLoad;      /* Audio thread load, 0.1% */
+static int FastBuf[SND_BUFSIZE];    /* SND_FAST EMULib output */
+int SoundStats = 0;                 /* 1: measure chip speed  */
+
+/** Resampler ************************************************/
+/** Chips may synthesize at a rate other than the output's. **/
+/** Their samples then go through a polyphase windowed-sinc **/
+/** filter, band-limited to the lower of the two Nyquist    **/
+/** frequencies so that neither images nor aliases get in.  **/
+/*************************************************************/
+#define RS_TAPS     32              /* Filter length, samples */
+#define RS_PHBITS   8               /* log2(filter phases)    */
+#define RS_PHASES   (1<<RS_PHBITS)
+#define RS_MAXRATIO 4               /* Max chip/output rate   */
+#define RS_INSIZE   (RS_MAXRATIO*SND_BUFSIZE+RS_TAPS+2)
+
+typedef struct
+{
+  unsigned int Step;                /* Inputs/output, 16.16; 0=off */
+  unsigned int Pos;                 /* Next output in In[], 16.16 */
+  int Avail;                        /* Samples held in In[]   */
+  int Quiet;                        /* Silent samples at its end */
+  short Coef[RS_PHASES][RS_TAPS];   /* Filter phases, Q14     */
+  INT16 In[RS_INSIZE];              /* Chip output history    */
+} Resampler;
+
+static Resampler Rs[SND_CHIPS];
+
+static int SamplesUntil(unsigned int Time);
+static void LimitChunk(short *Out);
+static int RenderChip(int Chip,INT16 *Out,int N);
+static int Resample(int Chip,INT16 *Out,int N);
+static void SetResampler(int Chip,unsigned int InRate,unsigned int OutRate);
+static void LoadChips(void);
+static void ApplyWrite(const SndEvent *E);
+static void QueueWrite(int Chip,int R,int V);
 #else
 static sample SndData[SND_BUFSIZE];
 static int MixBuffer[SND_BUFSIZE];
@@ -50,17 +182,43 @@ static int WPtr = 0;
 #endif
 
 int SoundSuspended = 0;
+int SoundBuffers = 2;        /* Wave buffers queued, 2..8    */
+int SoundBufSize = SND_BUFSIZE; /* Samples per wave buffer   */
 static int SndRate     = 0;  /* Audio sampling rate          */
 
 /** StopSound() **********************************************/
 /** Temporarily suspend sound.                              **/
 /*************************************************************/
-void StopSound(void) { pl_snd_pause(0); }
+void StopSound(void)
+{
+  /* Returns once the audio thread is out of MixAudio() */
+  pl_snd_pause(0);
+#if defined(FMSX) && defined(ALTSOUND)
+  /* Apply pending writes so later direct writes stay in */
+  /* order; the audio thread no longer reads the queue   */
+  if (SndRate)
+  {
+    while(SndTail!=SndHead)
+    {
+      ApplyWrite(&SndQueue[SndTail&SNDQ_MASK]);
+      SNDQ_BARRIER();
+      SndTail++;
+    }
+  }
+  SndPaused = 1;
+#endif
+}
 
 /** ResumeSound() ********************************************/
 /** Resume sound after StopSound().                         **/
 /*************************************************************/
-void ResumeSound(void) { pl_snd_resume(0); }
+void ResumeSound(void)
+{
+#if defined(FMSX) && defined(ALTSOUND)
+  SndPaused = 0;
+#endif
+  pl_snd_resume(0);
+}
 
 /** InitAudio() **********************************************/
 /** Initialize sound. Returns rate (Hz) on success, else 0. **/
@@ -68,8 +226,32 @@ void ResumeSound(void) { pl_snd_resume(0); }
 /*************************************************************/
 unsigned int InitAudio(unsigned int Rate,unsigned int Latency)
 {
+#if defined(FMSX) && defined(ALTSOUND)
+  unsigned int Hz[SND_CHIPS];
+  int J;
+#endif
+  pl_snd_stats S;
+
   TrashAudio();
 
+  /* Restart wave output if buffering has been changed */
+  if(SoundBuffers<PL_SND_MIN_BUFFERS) SoundBuffers=PL_SND_MIN_BUFFERS;
+  if(SoundBuffers>PL_SND_MAX_BUFFERS) SoundBuffers=PL_SND_MAX_BUFFERS;
+  SoundBufSize=PL_SND_ALIGN_SAMPLE(SoundBufSize);
+  if(SoundBufSize<SND_BUFSIZE) SoundBufSize=SND_BUFSIZE;
+  if(SoundBufSize>8*SND_BUFSIZE) SoundBufSize=8*SND_BUFSIZE;
+  if(!pl_snd_get_stats(0,&S)||(S.buffers!=SoundBuffers)||(S.samples!=SoundBufSize))
+  {
+    pl_snd_shutdown();
+    if(!pl_snd_init_ex(SoundBufSize,SoundBuffers,0))
+    {
+      /* Fall back to the default buffering */
+      SoundBuffers=2;
+      SoundBufSize=SND_BUFSIZE;
+      if(!pl_snd_init(SND_BUFSIZE,0)) return(SndRate=0);
+    }
+  }
+
   SoundSuspended = 0;
   pl_snd_set_callback(0, AudioCallback, 0);
 
@@ -77,31 +259,88 @@ unsigned int InitAudio(unsigned int Rate,unsigned int Latency)
   if(Rate != 44100) return(SndRate = 0);
 
 #if defined(FMSX) && defined(ALTSOUND)
+  /* Pick synthesis rates: high quality runs FM chips at */
+  /* their sample clock and oversamples PSG/SCC inside   */
+  for(J=0;J<SND_CHIPS;J++)
+    Hz[J]=(SoundQuality==SND_HIGH)||!SynthRate? Rate:SynthRate;
+  if(SoundQuality==SND_HIGH)
+    Hz[SND_OPLL]=Hz[SND_AUDIO]=MSX_CLK/72;
+  for(J=0;J<SND_CHIPS;J++)
+  {
+    if(Hz[J]>RS_MAXRATIO*Rate) Hz[J]=RS_MAXRATIO*Rate;
+    if(Hz[J]<Rate/RS_MAXRATIO) Hz[J]=Rate/RS_MAXRATIO;
+    SetResampler(J,Hz[J],Rate);
+  }
+
   /* MSX-MUSIC emulation */
-  if (Use2413)
+  if (Use2413 && (SoundQuality != SND_FAST))
   {
-    OPLL_init(MSX_CLK,Rate);
-    opll=OPLL_new();
+    opll=OPLL_new(MSX_CLK,Hz[SND_OPLL]);
     OPLL_reset(opll);
     OPLL_reset_patch(opll,0);
   }
 
-  /* MSX-AUDIO emulation */
-  if (Use8950)
+  /* MSX-AUDIO emulation, at every quality (no EMULib Y8950). */
+  /* Both engines address sample RAM the same way, so the   */
+  /* RAM is kept from the previous instance, whichever it was */
+  if (Use8950 && (AudioEngine == SND_EMU8950))
+  {
+    OPL_init(MSX_CLK,Hz[SND_AUDIO]);
+    y8950=OPL_new();
+
+    if (AudioRAM)
+    {
+      free(y8950->adpcm->memory[0]);
+      y8950->adpcm->memory[0]=y8950->adpcm->wave=AudioRAM;
+      AudioRAM=0;
+    }
+  }
+  else if (Use8950)
   {
-    fm_opl=OPLCreate(OPL_TYPE_Y8950,MSX_CLK,Rate,256);
+    fm_opl=OPLCreate(OPL_TYPE_Y8950,MSX_CLK,Hz[SND_AUDIO],256);
     OPLResetChip(fm_opl);
+
+    if (AudioRAM)
+    {
+      free(fm_opl->deltat->memory);
+      fm_opl->deltat->memory=AudioRAM;
+      AudioRAM=0;
+    }
+  }
+  else if (AudioRAM)
+  {
+    free(AudioRAM);
+    AudioRAM=0;
   }
 
-  /* PSG/SCC emulation */
-  PSG_init(MSX_CLK,Rate);
-  psg=PSG_new();
-  PSG_reset(psg);
-  PSG_setVolumeMode(psg,2);
+  /* PSG/SCC emulation, done by EMULib for SND_FAST */
+  if (SoundQuality != SND_FAST)
+  {
+    psg=PSG_new(MSX_CLK,Hz[SND_PSG]);
+    PSG_set_quality(psg,SoundQuality==SND_HIGH);
+    PSG_reset(psg);
+    PSG_setVolumeMode(psg,2);
+
+    scc=SCC_new(MSX_CLK,Hz[SND_SCC]);
+    SCC_set_quality(scc,SoundQuality==SND_HIGH);
+    SCC_reset(scc);
+  }
 
-  SCC_init(MSX_CLK,Rate);
-  scc=SCC_new();
-  SCC_reset(scc);
+  /* Register queue: audio trails emulation by a frame */
+  /* plus all wave buffers, so writes land in time     */
+  SndHead=SndTail=0;
+  SndNow=SndFrac=0;
+  SndStep=(unsigned int)(((unsigned long long)MSX_CLK<<16)/Rate);
+  SndLatency=MSX_CLK/50+
+    (int)(((unsigned long long)SoundBuffers*SoundBufSize*SndStep)>>16);
+  LoadChips();
+
+  /* Mixer: filter at rest, limiter fully open */
+  DCIn=DCOut=0;
+  memset(LimBuf,0,sizeof(LimBuf));
+  LimPeak[0]=LimPeak[1]=0;
+  LimCur=LimPos=0;
+  LimGain=32768;
 #else
   WPtr=0;
   memset(SndData,0,sizeof(SndData));
@@ -118,10 +357,13 @@ unsigned int InitAudio(unsigned int Rate,unsigned int Latency)
 void ResetSound()
 {
 #if defined(FMSX) && defined(ALTSOUND)
-  PSG_reset(psg);
-  SCC_reset(scc);
-  if (Use2413) OPLL_reset(opll);
-  if (Use8950) OPLResetChip(fm_opl);
+  /* Reset in order with the queued register writes */
+  memset(PSGRegs,0,sizeof(PSGRegs));
+  memset(SCCRegs,0,sizeof(SCCRegs));
+  memset(OPLLRegs,0,sizeof(OPLLRegs));
+  memset(AudioRegs,0,sizeof(AudioRegs));
+  SCCUsed=AudioLatch=0;
+  QueueWrite(SND_RESET,0,0);
 #endif
 }
 
@@ -138,18 +380,32 @@ void TrashAudio(void)
 
 #if defined(FMSX) && defined(ALTSOUND)
   /* clean up MSXMUSIC */
-  if (Use2413)
+  if (opll)
   {
-    OPLL_close();
     OPLL_delete(opll);
+    opll=0;
   }
 
-  /* clean up MSXAUDIO */
-  if (Use8950) OPLDestroy(fm_opl);
+  /* clean up MSXAUDIO, keeping sample RAM for InitAudio() */
+  if (fm_opl)
+  {
+    AudioRAM=fm_opl->deltat->memory;
+    fm_opl->deltat->memory=0;
+    OPLDestroy(fm_opl);
+    fm_opl=0;
+  }
+  if (y8950)
+  {
+    AudioRAM=y8950->adpcm->memory[0];
+    y8950->adpcm->memory[0]=0;
+    OPL_delete(y8950);
+    OPL_close();
+    y8950=0;
+  }
 
   /* clean up PSG/SCC */
-  PSG_delete(psg);
-  SCC_delete(scc);
+  if (psg) { PSG_delete(psg);psg=0; }
+  if (scc) { SCC_delete(scc);scc=0; }
 #endif
 }
 
@@ -159,9 +415,24 @@ void TrashAudio(void)
 static void AudioCallback(pl_snd_sample *buf, unsigned int samples, void *userdata)
 {
   if (SoundSuspended)
+  {
+#if defined(FMSX) && defined(ALTSOUND)
+    /* Keep chip registers current while not rendering */
+    while(SndTail!=SndHead)
+    {
+      SndNow=SndQueue[SndTail&SNDQ_MASK].Time;
+      ApplyWrite(&SndQueue[SndTail&SNDQ_MASK]);
+      SNDQ_BARRIER();
+      SndTail++;
+    }
+#endif
     memset(buf, 0, samples << 1);
+  }
   else
     MixAudio((short*)buf, samples);
+
+  /* Record what is being played, if capturing */
+  pl_capture_put_samples((short*)buf, samples);
 }
 
 /** AudioCallback() ******************************************/
@@ -173,30 +444,136 @@ static void MixAudio(short *buffer, unsigned int length)
   register int J;
 
 #if defined(FMSX) && defined(ALTSOUND)
-  register int R;
-  register INT16 P,O,A,S;
+  register int R,K,N;
+  register const SndEvent *E;
+  register const INT16 *B;
+  int Live[SND_CHIPS],Gain[SND_CHIPS];
+  u64 S,T,U;
+
+  if(SoundStats) sceRtcGetCurrentTick(&S);
+
+  /* Gains may change from the menu at any time */
+  for(K=0;K<SND_CHIPS;K++)
+    Gain[K]=(ChipGain[K]*(SoundGain[K]>200? 200:SoundGain[K])/100)>>4;
+
+  /* emu8950 comes out about 12dB quieter than fmopl */
+  if(y8950) Gain[SND_AUDIO]<<=2;
+
+  /* Resynchronize with emulation if it ran too far */
+  /* ahead or behind the audio clock                */
+  if(SndTail!=SndHead)
+  {
+    R=(int)(SndQueue[SndTail&SNDQ_MASK].Time-SndNow);
+    if((R>2*SndLatency)||(R<-SndLatency))
+      SndNow=SndQueue[SndTail&SNDQ_MASK].Time-SndLatency;
+  }
 
   /* Mix sound */
-  for(J=0;J<length;J++)
+  for(J=0;J<length;J+=N)
   {
-    P=PSG_calc(psg);
-    S=SCC_calc(scc);
-    O=Use2413? OPLL_calc(opll): 0;
-    A=Use8950? Y8950UpdateOne(fm_opl): 0;
-    R=P*FactorPSG+O*Factor2413+A*Factor8950+S*FactorSCC;
+    /* Apply register writes due by this sample */
+    while(SndTail!=SndHead)
+    {
+      E=&SndQueue[SndTail&SNDQ_MASK];
+      if((int)(E->Time-SndNow)>0) break;
+      ApplyWrite(E);
+      SNDQ_BARRIER();
+      SndTail++;
+    }
+
+    /* Render up to the sample where the next write is due */
+    N=length-J>SND_BUFSIZE? SND_BUFSIZE:length-J;
+    if(SndTail!=SndHead)
+    {
+      K=SamplesUntil(SndQueue[SndTail&SNDQ_MASK].Time);
+      if(K<N) N=K;
+    }
+
+    /* Advance audio clock by N samples */
+    SndFrac+=N*SndStep;
+    SndNow+=SndFrac>>16;
+    SndFrac&=0xFFFF;
+
+    /* Silent chips render nothing and are left out of the mix */
+    if(SoundStats) sceRtcGetCurrentTick(&T);
+    for(K=0;K<SND_CHIPS;K++)
+    {
+      Live[K]=Rs[K].Step? Resample(K,ChipBuf[K],N):RenderChip(K,ChipBuf[K],N);
+      if(SoundStats) { sceRtcGetCurrentTick(&U);ChipTicks[K]+=U-T;T=U; }
+    }
+
+    /* Sum audible chips: Q15 gains taken down to Q11 */
+    /* keep four full-scale chips within 32 bits      */
+    memset(MixBuf,0,N*sizeof(int));
+    for(R=0;R<SND_CHIPS;R++)
+      if(Live[R]&&Gain[R])
+        for(B=ChipBuf[R],K=0;K<N;K++) MixBuf[K]+=B[K]*Gain[R];
+
+    /* SND_FAST: PSG, SCC, OPLL come from EMULib channels, */
+    /* scaled to 16 bits the way PlayAudio() would do it   */
+    if(SoundQuality==SND_FAST)
+    {
+      memset(FastBuf,0,N*sizeof(int));
+      RenderAudio(FastBuf,N);
+      for(K=0;K<N;K++)
+      {
+        R=FastBuf[K]*MasterVolume/255;
+        R=R>32767? 32767:R<-32768? -32768:R;
+        MixBuf[K]+=R<<11;
+      }
+    }
+
+    /* Remove DC (PSG output is unipolar), feed limiter */
+    for(K=0;K<N;K++)
+    {
+      R=MixBuf[K]>>7;
+      DCOut=R-DCIn+DCOut-(DCOut>>9);
+      DCIn=R;
+
+      R=DCOut>>4;
+      LimBuf[LimCur][LimPos]=R;
+      if(R<0) R=-R;
+      if(R>LimPeak[LimCur]) LimPeak[LimCur]=R;
+      if(++LimPos==LIM_CHUNK) { LimitChunk(buffer);buffer+=LIM_CHUNK; }
+    }
+  }
 
-    /* Write to output buffer */
-    *buffer++ = (R>32767)?32767:(R<-32768)?-32768:R;
+  /* Once a second of sound is measured, update ChipRate[] */
+  /* and the share of real time the audio thread is busy    */
+  if(SoundStats) { sceRtcGetCurrentTick(&T);MixTicks+=T-S; }
+  if(SoundStats&&((ChipCount+=length)>=SndRate))
+  {
+    SoundLoad=(unsigned int)(MixTicks*1000*SndRate/
+      ((u64)ChipCount*sceRtcGetTickResolution()));
+    MixTicks=0;
+
+    for(K=0;K<SND_CHIPS;K++)
+    {
+      ChipRate[K]=ChipTicks[K]?
+        (unsigned int)((u64)ChipCount*sceRtcGetTickResolution()/ChipTicks[K]):0;
+      ChipTicks[K]=0;
+    }
+    ChipCount=0;
+
+    /* Chips not being emulated are not measured */
+    if(!Use2413) ChipRate[SND_OPLL]=0;
+    if(!Use8950) ChipRate[SND_AUDIO]=0;
   }
 #else
-  /* Mix sound */
-  memset(MixBuffer,0,sizeof(MixBuffer));
-  RenderAudio(MixBuffer,length);
-  PlayAudio(MixBuffer,length);
+  register int K,N;
 
-  /* Write to output buffer */
-  for(J=0;J<length;J++)
-    *buffer++ = SndData[J];
+  /* Mix sound, a wave buffer at a time */
+  for(J=0;J<length;J+=N)
+  {
+    N=length-J>SND_BUFSIZE? SND_BUFSIZE:length-J;
+    memset(MixBuffer,0,sizeof(MixBuffer));
+    RenderAudio(MixBuffer,N);
+    PlayAudio(MixBuffer,N);
+
+    /* Write to output buffer */
+    for(K=0;K<N;K++)
+      *buffer++ = SndData[K];
+  }
 #endif
 }
 
@@ -235,11 +612,297 @@ unsigned int WriteAudio(sample *Data,unsigned int Length)
 }
 
 #if defined(FMSX) && defined(ALTSOUND)
+/** SamplesUntil() *******************************************/
+/** Return the number of samples rendered before a write    **/
+/** stamped Time is due. Time must be in the future.        **/
+/*************************************************************/
+static int SamplesUntil(unsigned int Time)
+{
+  long long D=((long long)(int)(Time-SndNow)<<16)-SndFrac;
+  return((int)((D+SndStep-1)/SndStep));
+}
+
+/** LimitChunk() *********************************************/
+/** Output the delayed chunk, ramping the gain so that      **/
+/** neither it nor the incoming chunk exceeds the limit.    **/
+/*************************************************************/
+static void LimitChunk(short *Out)
+{
+  register int J,G,D,Step;
+  int Need[2];
+
+  /* Highest gain each chunk can take */
+  for(J=0;J<2;J++)
+    Need[J]=LimPeak[J]>LIM_THRESHOLD?
+      (int)(((long long)LIM_THRESHOLD<<15)/LimPeak[J]):32768;
+
+  /* Aim below both chunks' limits, recover slowly */
+  D=LimCur^1;
+  G=LimGain+LIM_RELEASE;
+  if(G>32768) G=32768;
+  if(G>Need[D]) G=Need[D];
+  if(G>Need[LimCur]) G=Need[LimCur];
+
+  /* Both ends of the ramp are within Need[D] */
+  Step=(G-LimGain)/LIM_CHUNK;
+  for(J=0;J<LIM_CHUNK;J++)
+  {
+    register int S=(int)(((long long)LimBuf[D][J]*(LimGain+Step*(J+1)))>>15);
+    Out[J]=S>32767? 32767:S<-32768? -32768:S;
+  }
+
+  /* Incoming chunk is now the delayed one */
+  LimGain=LimGain+Step*LIM_CHUNK;
+  LimPeak[D]=0;
+  LimCur=D;
+  LimPos=0;
+}
+
+/** RenderChip() *********************************************/
+/** Render N samples of a chip at its synthesis rate.       **/
+/** Returns 0 if the chip is silent or not emulated.        **/
+/*************************************************************/
+static int RenderChip(int Chip,INT16 *Out,int N)
+{
+  switch(Chip)
+  {
+    case SND_PSG:   return(psg&&PSG_calc_block(psg,Out,N));
+    case SND_SCC:   return(scc&&SCC_calc_block(scc,Out,N));
+    case SND_OPLL:  return(opll&&OPLL_calc_block(opll,Out,N));
+    case SND_AUDIO:
+      if(y8950) return(OPL_calc_block(y8950,Out,N));
+      return(fm_opl&&Y8950UpdateBlock(fm_opl,Out,N));
+  }
+  return(0);
+}
+
+/** Resample() ***********************************************/
+/** Render N output-rate samples of a chip that runs at a   **/
+/** different rate. Returns 0 if the result is silent.      **/
+/*************************************************************/
+static int Resample(int Chip,INT16 *Out,int N)
+{
+  register Resampler *R=&Rs[Chip];
+  register const short *C;
+  register const INT16 *I;
+  register int J,K,S;
+  int Live;
+
+  /* Render as many chip samples as these outputs reach */
+  K=((R->Pos+(N-1)*R->Step)>>16)+RS_TAPS-R->Avail;
+  if(K>0)
+  {
+    if(RenderChip(Chip,R->In+R->Avail,K)) R->Quiet=0;
+    else
+    {
+      memset(R->In+R->Avail,0,K*sizeof(INT16));
+      R->Quiet+=K;
+    }
+    R->Avail+=K;
+  }
+
+  /* Skip the filter while all it sees is silence */
+  Live=R->Quiet<R->Avail;
+  if(!Live) R->Pos+=N*R->Step;
+  else
+    for(J=0;J<N;J++,R->Pos+=R->Step)
+    {
+      I=R->In+(R->Pos>>16);
+      C=R->Coef[(R->Pos>>(16-RS_PHBITS))&(RS_PHASES-1)];
+      for(S=K=0;K<RS_TAPS;K++) S+=I[K]*C[K];
+      S>>=14;
+      Out[J]=S>32767? 32767:S<-32768? -32768:S;
+    }
+
+  /* Drop chip samples no later output will need */
+  K=R->Pos>>16;
+  R->Avail-=K;
+  memmove(R->In,R->In+K,R->Avail*sizeof(INT16));
+  R->Pos&=0xFFFF;
+  if(R->Quiet>R->Avail) R->Quiet=R->Avail;
+
+  return(Live);
+}
+
+/** SetResampler() *******************************************/
+/** Set up conversion of a chip from InRate to OutRate, or  **/
+/** turn it off if the rates are the same.                  **/
+/*************************************************************/
+static void SetResampler(int Chip,unsigned int InRate,unsigned int OutRate)
+{
+  register Resampler *R=&Rs[Chip];
+  double Fc,X,W,Sum,H[RS_TAPS];
+  int J,K,S;
+
+  memset(R,0,sizeof(Resampler));
+  if(InRate==OutRate) return;
+
+  /* Start with a full window of silence */
+  R->Step=(unsigned int)(((unsigned long long)InRate<<16)/OutRate);
+  R->Avail=R->Quiet=RS_TAPS;
+
+  /* Cutoff below the lower Nyquist, in input samples */
+  Fc=0.9*(InRate<OutRate? 1.0:(double)OutRate/InRate);
+
+  /* Phase J is centered J/RS_PHASES past tap RS_TAPS/2-1 */
+  for(J=0;J<RS_PHASES;J++)
+  {
+    for(K=0,Sum=0.0;K<RS_TAPS;K++)
+    {
+      X=K-(RS_TAPS/2-1)-(double)J/RS_PHASES;
+      W=(X+RS_TAPS/2)/RS_TAPS;
+      W=0.42-0.5*cos(2*M_PI*W)+0.08*cos(4*M_PI*W);
+      H[K]=W*(X? sin(M_PI*Fc*X)/(M_PI*X):Fc);
+      Sum+=H[K];
+    }
+
+    /* Unity gain at DC for every phase */
+    for(K=S=0;K<RS_TAPS;K++)
+    {
+      R->Coef[J][K]=(short)floor(H[K]*16384.0/Sum+0.5);
+      S+=R->Coef[J][K];
+    }
+    R->Coef[J][RS_TAPS/2-1]+=16384-S;
+  }
+}
+
+/** GetChipRate() ********************************************/
+/** Return samples/second a sound chip renders at, or 0 if  **/
+/** not measured (SoundStats=0, chip unused).               **/
+/*************************************************************/
+unsigned int GetChipRate(int Chip)
+{
+  return(SoundStats&&(Chip>=0)&&(Chip<SND_CHIPS)? ChipRate[Chip]:0);
+}
+
+/** GetSoundLoad() *******************************************/
+/** Return the share of real time the audio thread spends   **/
+/** mixing, in 0.1% units, or 0 if not measured.            **/
+/*************************************************************/
+unsigned int GetSoundLoad(void)
+{
+  return(SoundStats? SoundLoad:0);
+}
+
+/** LoadChips() **********************************************/
+/** Load chips just created by InitAudio() with the values  **/
+/** last written to their registers.                        **/
+/*************************************************************/
+static void LoadChips(void)
+{
+  register int J,K;
+  SndEvent E;
+
+  if(psg)
+    for(J=0;J<16;J++) PSG_writeReg(psg,J,PSGRegs[J]);
+
+  if(scc)
+    for(K=0;K<2;K++)
+      if(SCCUsed&(1<<K))
+        for(J=0;J<256;J++) SCC_write(scc,(K? 0xB800:0x9800)+J,SCCRegs[K][J]);
+
+  if(opll)
+    for(J=0;J<64;J++) OPLL_writeReg(opll,J,OPLLRegs[J]);
+
+  /* MSX-AUDIO, through whichever engine is in use. Leave */
+  /* out IRQ reset, ADPCM start, and sample RAM data       */
+  E.Time=0;
+  E.Chip=SND_AUDIO;
+  for(J=0;J<256;J++)
+    if((J!=0x04)&&(J!=0x07)&&(J!=0x0F))
+    {
+      E.Reg=0;E.Value=J;ApplyWrite(&E);
+      E.Reg=1;E.Value=AudioRegs[J];ApplyWrite(&E);
+    }
+  E.Reg=0;E.Value=AudioLatch;ApplyWrite(&E);
+}
+
+/** ApplyWrite() *********************************************/
+/** Apply a queued register write to its sound chip, if it  **/
+/** is being emulated.                                      **/
+/*************************************************************/
+static void ApplyWrite(const SndEvent *E)
+{
+  switch(E->Chip)
+  {
+    case SND_PSG:   if(psg) PSG_writeReg(psg,E->Reg,E->Value);break;
+    case SND_SCC:   if(scc) SCC_write(scc,E->Reg,E->Value);break;
+    case SND_OPLL:  if(opll) OPLL_writeReg(opll,E->Reg,E->Value);break;
+    case SND_AUDIO:
+      if(fm_opl) OPLWrite(fm_opl,E->Reg,E->Value);
+      if(y8950) OPL_writeIO(y8950,E->Reg,E->Value);
+      break;
+    case SND_RESET:
+      if(psg) PSG_reset(psg);
+      if(scc) SCC_reset(scc);
+      if(opll) OPLL_reset(opll);
+      if(fm_opl) OPLResetChip(fm_opl);
+      if(y8950) OPL_reset(y8950);
+      break;
+  }
+}
+
+/** QueueWrite() *********************************************/
+/** Timestamp a register write and pass it to the audio     **/
+/** thread. Applied at once when the audio thread is idle.  **/
+/*************************************************************/
+static void QueueWrite(int Chip,int R,int V)
+{
+  register SndEvent *E;
+  register unsigned int H=SndHead;
+
+  /* EMULib plays these for SND_FAST, shadows suffice */
+  if((SoundQuality==SND_FAST)&&(Chip<SND_AUDIO)) return;
+
+  /* Nobody is rendering, apply directly */
+  if(!SndRate||SndPaused)
+  {
+    SndEvent D;
+    D.Time=0;D.Chip=Chip;D.Reg=R;D.Value=V;
+    ApplyWrite(&D);
+    return;
+  }
+
+  /* Queue full: let the audio thread catch up */
+  while(H-SndTail>=SNDQ_SIZE) sceKernelDelayThread(1000);
+
+  E=&SndQueue[H&SNDQ_MASK];
+  E->Time=SoundClock();
+  E->Chip=Chip;
+  E->Reg=R;
+  E->Value=V;
+
+  /* Publish the entry only once it is complete */
+  SNDQ_BARRIER();
+  SndHead=H+1;
+}
+
 /* wrapper functions to actual sound emulation */
-void WriteOPLL (int R,int V) { OPLL_writeReg(opll,R,V); }
-void WriteAUDIO(int R,int V) { OPLWrite(fm_opl,R,V); }
-void Write2212 (int R,int V) { SCC_write(scc,R,V); }
-void WritePSG  (int R,int V) { PSG_writeReg(psg,R,V); }
-int  ReadAUDIO (int R)       { return OPLRead(fm_opl,R); }
-int  ReadPSG   (int R)       { return PSG_readReg(psg,R); }
+void WriteOPLL (int R,int V)
+{
+  OPLLRegs[R&0x3F]=V;
+  QueueWrite(SND_OPLL,R,V);
+}
+void WriteAUDIO(int R,int V)
+{
+  if(R&1) AudioRegs[AudioLatch]=V; else AudioLatch=V;
+  QueueWrite(SND_AUDIO,R,V);
+}
+void Write2212 (int R,int V)
+{
+  SCCRegs[(R>>13)&1][R&0xFF]=V;
+  SCCUsed|=1<<((R>>13)&1);
+  QueueWrite(SND_SCC,R,V);
+}
+void WritePSG  (int R,int V)
+{
+  if(R<16) PSGRegs[R]=V;
+  QueueWrite(SND_PSG,R,V);
+}
+int  ReadAUDIO (int R)
+{
+  if(y8950) return(R&1? OPL_readIO(y8950):OPL_status(y8950));
+  return(fm_opl? OPLRead(fm_opl,R):0xFF);
+}
+int  ReadPSG   (int R)       { return PSGRegs[R&0x1F]; }
 #endif
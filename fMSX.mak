@@ -12,7 +12,8 @@ DEFINES=-DFMSX -DDISK
 
 ifdef MSXAUDIO
 ifdef MSXMUSIC
-BUILD_MSXMUSIC=$(MSXMUSIC)/emu2413.o $(MSXMUSIC)/emu2212.o $(MSXMUSIC)/emu2149.o
+BUILD_MSXMUSIC=$(MSXMUSIC)/emu2413.o $(MSXMUSIC)/emu2212.o $(MSXMUSIC)/emu2149.o \
+               $(MSXMUSIC)/emu8950.o $(MSXMUSIC)/emuadpcm.o
 BUILD_MSXAUDIO=$(MSXAUDIO)/fmopl.o $(MSXAUDIO)/ymdeltat.o
 BUILD_SOUNDLIB=$(BUILD_MSXMUSIC) $(BUILD_MSXAUDIO)
 DEFINES += -DALTSOUND
@@ -32,3 +33,31 @@ TARGET=fmsxpsp
 PSP_EBOOT_ICON=data/fmsx-icon.png
 
 include Common.mak
+
+ifdef BUILD_SOUNDLIB
+# Sound chip tables for the default clock and rate, generated
+# at build time by the emulators themselves on the build host
+HOSTCC?=cc
+
+$(MSXMUSIC)/emu2413.o: $(MSXMUSIC)/2413tbl.h
+$(MSXAUDIO)/fmopl.o: $(MSXAUDIO)/fmopltbl.h
+
+$(MSXMUSIC)/2413tbl.h: $(MSXMUSIC)/emu2413.c $(MSXMUSIC)/emu2413.h
+	$(HOSTCC) -DEMU2413_MKTABLES -o mk2413tbl $(MSXMUSIC)/emu2413.c -lm
+	./mk2413tbl > $@.tmp
+	rm -f mk2413tbl
+	mv $@.tmp $@
+
+$(MSXAUDIO)/fmopltbl.h: $(MSXAUDIO)/fmopl.c $(MSXAUDIO)/fmopl.h
+	$(HOSTCC) -DFMOPL_MKTABLES -o mkfmopltbl $(MSXAUDIO)/fmopl.c $(MSXAUDIO)/ymdeltat.c -lm
+	./mkfmopltbl > $@.tmp
+	rm -f mkfmopltbl
+	mv $@.tmp $@
+
+clean: clean_soundtables
+
+clean_soundtables:
+	rm -f $(MSXMUSIC)/2413tbl.h $(MSXAUDIO)/fmopltbl.h \
+	  $(MSXMUSIC)/2413tbl.h.tmp $(MSXAUDIO)/fmopltbl.h.tmp \
+	  mk2413tbl mkfmopltbl
+endif
@@ -15,8 +15,11 @@
 
 static int FirstLine = 18;     /* First scanline in the XBuf */
 
+/* Empty ZBuf used on lines where ColorSprites() drew nothing */
+static unsigned int NoSprites[304/sizeof(int)];
+
 static void  Sprites(byte Y,pixel *Line);
-static void  ColorSprites(byte Y,byte *ZBuf);
+static int   ColorSprites(byte Y,byte *ZBuf);
 static pixel *RefreshBorder(byte Y,pixel C);
 static void  ClearLine(pixel *P,pixel C);
 static pixel YJKColor(int Y,int J,int K);
@@ -27,6 +30,101 @@ static void  HiResRefreshLine6(register byte Y);
 static void  HiResRefreshLine7(register byte Y);
 static void  HiResRefreshLineTx80(register byte Y);
 
+/** Word-wide rendering **************************************/
+/** Bitmap SCREENs render runs of eight pixels that have no **/
+/** sprites in them by reading four VRAM bytes per 32bit    **/
+/** load and storing two 16bit pixels per 32bit write. The  **/
+/** per-pixel loops remain as the reference path, used for  **/
+/** pixels covered by sprites, non-16bit builds, misaligned **/
+/** buffers, or when NO_WIDE_RENDER is defined.             **/
+/*************************************************************/
+#if defined(BPP16) && !defined(NO_WIDE_RENDER)
+#define WIDE_OK(P,T) !(((unsigned long)(P)|(unsigned long)(T))&3)
+#else
+#define WIDE_OK(P,T) 0
+#endif
+
+#ifdef LSB_FIRST
+#define PIX2(A,B)   ((unsigned int)(A)|((unsigned int)(B)<<16))
+#define VBYTE(W,N)  (((W)>>(8*(N)))&0xFF)
+#else
+#define PIX2(A,B)   (((unsigned int)(A)<<16)|(unsigned int)(B))
+#define VBYTE(W,N)  (((W)>>(24-8*(N)))&0xFF)
+#endif
+
+/* Nonzero if no sprite pixels among ZBuf entries R[0..3]/R[0..7] */
+#define NOSPR4(R)   !((unsigned int *)(R))[0]
+#define NOSPR8(R)   !(((unsigned int *)(R))[0]|((unsigned int *)(R))[1])
+
+/* XPal[N], valid even before RefreshBorder() updates XPal[0] */
+#define XPAL(N)     ((N)? XPal[N]:(!BGColor||SolidColor0)? XPal0:XPal[BGColor])
+
+/** Glyph cache **********************************************/
+/** Character SCREENs copy pattern rows from a cache of     **/
+/** rows already expanded into pixels. Entries are keyed by **/
+/** the pattern byte together with the two pixel values it  **/
+/** expands into, so ChrGen/ColTab writes and palette       **/
+/** changes simply miss the cache instead of requiring it   **/
+/** to be invalidated.                                      **/
+/*************************************************************/
+#define GLYPHS 1024             /* Cache entries, power of 2 */
+
+typedef struct
+{
+  pixel P[8];                   /* Pattern row as 8 pixels   */
+  pixel FC,BC;                  /* Colors for 1s and 0s      */
+  unsigned int K;               /* Pattern|0x100, 0 if empty */
+} Glyph;
+
+static Glyph GlyphCache[GLYPHS];
+
+/** GetGlyph() ***********************************************/
+/** Return pattern byte K expanded into 8 pixels, FC for    **/
+/** each set bit and BC for each cleared bit.               **/
+/*************************************************************/
+INLINE pixel *GetGlyph(register byte K,register pixel FC,register pixel BC)
+{
+  register Glyph *G;
+  register pixel *P;
+
+  G = GlyphCache
+    + ((K^((((unsigned int)FC*0x9E3779B1)^((unsigned int)BC*0x85EBCA6B))>>16))
+    & (GLYPHS-1));
+
+  if((G->K!=((unsigned int)K|0x100))||(G->FC!=FC)||(G->BC!=BC))
+  {
+    P=G->P;
+    P[0]=K&0x80? FC:BC;P[1]=K&0x40? FC:BC;
+    P[2]=K&0x20? FC:BC;P[3]=K&0x10? FC:BC;
+    P[4]=K&0x08? FC:BC;P[5]=K&0x04? FC:BC;
+    P[6]=K&0x02? FC:BC;P[7]=K&0x01? FC:BC;
+    G->K=(unsigned int)K|0x100;
+    G->FC=FC;
+    G->BC=BC;
+  }
+
+  return(G->P);
+}
+
+/** PutGlyph() ***********************************************/
+/** Copy 8 pixels of an expanded pattern row G to P.        **/
+/*************************************************************/
+INLINE void PutGlyph(register pixel *P,register pixel *G)
+{
+  if(WIDE_OK(P,G))
+  {
+    ((unsigned int *)P)[0]=((unsigned int *)G)[0];
+    ((unsigned int *)P)[1]=((unsigned int *)G)[1];
+    ((unsigned int *)P)[2]=((unsigned int *)G)[2];
+    ((unsigned int *)P)[3]=((unsigned int *)G)[3];
+  }
+  else
+  {
+    P[0]=G[0];P[1]=G[1];P[2]=G[2];P[3]=G[3];
+    P[4]=G[4];P[5]=G[5];P[6]=G[6];P[7]=G[7];
+  }
+}
+
 /** RefreshScreen() ******************************************/
 /** Refresh screen. This function is called in the end of   **/
 /** refresh cycle to show the entire screen.                **/
@@ -72,6 +170,60 @@ INLINE pixel YJKColor(register int Y,register int J,register int K)
   return(BPal[(R&0x1C)|((G&0x1C)<<3)|(B>>3)]);
 }
 
+/** YJK table ************************************************/
+/** SCREENs 10-12 look YJK colors up in a table covering    **/
+/** all 2^17 Y/J/K combinations. The table is built from    **/
+/** BPal on first use and rebuilt after the machine driver  **/
+/** clears YJKReady, i.e. when the pixel format changes.    **/
+/** Index is Y<<12|J<<6|K, with J and K in raw 6bit form.   **/
+/*************************************************************/
+static pixel YJKTab[0x20000];
+#define YJK(Y,JK) YJKTab[((int)(Y)<<12)|(JK)]
+
+/** BuildYJK() ***********************************************/
+/** Fill YJKTab[] with YJKColor() results.                  **/
+/*************************************************************/
+static void BuildYJK(void)
+{
+  register int Y,J,K;
+  register pixel *P;
+
+  for(Y=0,P=YJKTab;Y<32;Y++)
+    for(J=0;J<64;J++)
+      for(K=0;K<64;K++)
+        *P++=YJKColor(Y,J&0x20? J-64:J,K&0x20? K-64:K);
+
+  YJKReady=1;
+}
+
+/** Border cache *********************************************/
+/** Border rows stay in the screen buffer between frames,   **/
+/** so RefreshBorder() only repaints a row when its color,  **/
+/** HAdjust, or kind (side/full, low/high resolution)       **/
+/** differs from what BorderKey[] says was painted there.   **/
+/** Clear BorderKey[] if the buffer is overwritten.         **/
+/*************************************************************/
+#define BORDER_SIDE    0x00000000  /* Left/right borders only */
+#define BORDER_FULL    0x00100000  /* Entire row is border    */
+#define BORDER_HIRES   0x00200000  /* 512-pixel row           */
+#define BORDER_KEY(C,F) (0x80000000|(F)|((HAdjust&0x0F)<<16)|(C))
+
+/** BorderRow() **********************************************/
+/** Fill row R of the screen buffer with color C, N pixels  **/
+/** wide, unless it already holds such a fill.              **/
+/*************************************************************/
+static void BorderRow(int R,pixel C,int N,unsigned int F)
+{
+  register pixel *P;
+  register unsigned int K;
+
+  K=BORDER_KEY(C,F|BORDER_FULL);
+  if((R>=HEIGHT)||(BorderKey[ScreenPage][R]==K)) return;
+  BorderKey[ScreenPage][R]=K;
+
+  for(P=(pixel *)Screen->Pixels+Screen->Width*R;N>0;N--) *P++=C;
+}
+
 /** RefreshBorder() ******************************************/
 /** This function is called from RefreshLine#() to refresh  **/
 /** the screen border. It returns a pointer to the start of **/
@@ -80,8 +232,8 @@ INLINE pixel YJKColor(register int Y,register int J,register int K)
 pixel *RefreshBorder(register byte Y,register pixel C)
 {
   register pixel *P;
-  register int H;
-  register int E,I,J,S;
+  register unsigned int K;
+  register int H,E,I;
 
   /* First line number in the buffer */
   if(!Y) FirstLine=(ScanLines212? 8:18)+VAdjust;
@@ -92,38 +244,26 @@ pixel *RefreshBorder(register byte Y,register pixel C)
   /* Set up the transparent color */
   XPal[0]=(!BGColor||SolidColor0)? XPal0:XPal[BGColor];
 
-  /* Start of the buffer */
-  P=(pixel *)Screen->Pixels;
-
   /* Paint top of the screen */
-  S=Screen->Width-WIDTH;
-  if(!Y)
-  {
-    for(I=0,H=0;I<FirstLine;I++)
-    {
-      for(J=0;J<WIDTH;J++,H++) P[H]=C;
-      H+=S;
-    }
-  }
+  if(!Y) for(I=0;I<FirstLine;I++) BorderRow(I,C,WIDTH,0);
 
   /* Start of the line */
-  P+=Screen->Width*(FirstLine+Y);
-
-  /* Paint left/right borders */
+  P=(pixel *)Screen->Pixels+Screen->Width*(FirstLine+Y);
   E=(WIDTH-256)>>1;
-  for(H=E+HAdjust;H>0;H--) P[H-1]=C;
-  for(H=E-HAdjust;H>0;H--) P[WIDTH-H]=C;
+
+  /* Paint left/right borders, if changed */
+  K=BORDER_KEY(C,BORDER_SIDE);
+  if(BorderKey[ScreenPage][FirstLine+Y]!=K)
+  {
+    BorderKey[ScreenPage][FirstLine+Y]=K;
+    for(H=E+HAdjust;H>0;H--) P[H-1]=C;
+    for(H=E-HAdjust;H>0;H--) P[WIDTH-H]=C;
+  }
 
   /* Paint bottom of the screen */
   H=ScanLines212? 212:192;
   if(Y==H-1)
-  {
-    for(I=FirstLine,H=Screen->Width;I>0;I--)
-    {
-      for(J=0;J<WIDTH;J++,H++) P[H]=C;
-      H+=S;
-    }
-  }
+    for(I=1;I<=FirstLine;I++) BorderRow(FirstLine+Y+I,C,WIDTH,0);
 
   /* Return pointer to the scanline in XBuf */
   return(P+E+HAdjust);
@@ -137,34 +277,30 @@ pixel *RefreshBorder(register byte Y,register pixel C)
 pixel *HiResRefreshBorder(register byte Y,register pixel C)
 {
   register pixel *P;
-  register int H;
-  register int I,J,S;
+  register int H,I;
 
   /* First line number in the buffer */
   if(!Y) FirstLine=(ScanLines212? 8:18)+VAdjust;
 
-  /* Return 0 if we've run out of the screen buffer due to overscan */
-  if(Y+FirstLine>=HEIGHT) return(0);
+  /* Return 0 if we've run out of the screen buffer due to overscan, */
+  /* including the last row shifted right, which would spill past it  */
+  if(Y+FirstLine>=HEIGHT-(HAdjust>0)) return(0);
 
   /* Set up the transparent color */
   XPal[0]=(!BGColor||SolidColor0)? XPal0:XPal[BGColor];
 
-  /* Start of the buffer */
-  P=(pixel *)Screen->Pixels;
-
   /* Paint top of the screen */
-  S=Screen->Width-HIRES_WIDTH;
-  if(!Y)
-  {
-    for(I=0,H=0;I<FirstLine;I++)
-    {
-      for(J=0;J<HIRES_WIDTH;J++,H++) P[H]=C;
-      H+=S;
-    }
-  }
+  if(!Y) for(I=0;I<FirstLine;I++) BorderRow(I,C,HIRES_WIDTH,BORDER_HIRES);
+
+  /* This line covers the whole row, and spills into the */
+  /* neighbouring one when HAdjust is set                */
+  I=FirstLine+Y;
+  BorderKey[ScreenPage][I]=0;
+  if((HAdjust>0)&&(I<HEIGHT-1)) BorderKey[ScreenPage][I+1]=0;
+  if((HAdjust<0)&&(I>0))        BorderKey[ScreenPage][I-1]=0;
 
   /* Start of the line */
-  P+=Screen->Width*(FirstLine+Y);
+  P=(pixel *)Screen->Pixels+Screen->Width*I;
 
   /* Paint left/right borders */
   register int E=(HIRES_WIDTH-512)>>1;
@@ -174,13 +310,8 @@ pixel *HiResRefreshBorder(register byte Y,register pixel C)
   /* Paint bottom of the screen */
   H=ScanLines212? 212:192;
   if(Y==H-1)
-  {
-    for(I=FirstLine,H=Screen->Width;I>0;I--)
-    {
-      for(J=0;J<HIRES_WIDTH;J++,H++) P[H]=C;
-      H+=S;
-    }
-  }
+    for(I=1;I<=FirstLine;I++)
+      BorderRow(FirstLine+Y+I,C,HIRES_WIDTH,BORDER_HIRES);
 
   /* Return pointer to the scanline in XBuf */
   return(P+E+HAdjust);
@@ -193,171 +324,144 @@ pixel *HiResRefreshBorder(register byte Y,register pixel C)
 void Sprites(register byte Y,register pixel *Line)
 {
   register pixel *P,C;
-  register byte H,*PT,*AT;
-  register unsigned int M;
-  register int L,K;
+  register byte H,*PT,*AT,*S;
+  register int L,K,N;
 
-  /* Assign initial values before counting */
+  /* Find sprites in this line, up to MAXSPRITE1 sprites */
   H=Sprites16x16? 16:8;
-  C=0;M=0;L=0;
-  AT=SprTab-4;
   Y+=VScroll;
+  S=SpriteLine(Y,208,0);
+  N=S[0];
+  if((N>MAXSPRITE1)&&!OPTION(MSX_ALLSPRITE)) N=MAXSPRITE1;
 
-  /* Count displayed sprites */
-  do
+  /* Draw sprites, the first one on top */
+  for(;N;N--)
   {
-    M<<=1;AT+=4;L++;    /* Iterating through SprTab      */
-    K=AT[0];            /* K = sprite Y coordinate       */
-    if(K==208) break;   /* Iteration terminates if Y=208 */
-    if(K>256-H) K-=256; /* Y coordinate may be negative  */
+    AT=SprTab+((int)S[N]<<2);
+    C=AT[3];                  /* C = sprite attributes */
+    L=C&0x80? AT[1]-32:AT[1]; /* Sprite may be shifted left by 32 */
+    C&=0x0F;                  /* C = sprite color */
 
-    /* Mark all valid sprites with 1s, break at MAXSPRITE1 sprites */
-    if((Y>K)&&(Y<=K+H))
+    if((L<256)&&(L>-H)&&C)
     {
-      M|=1;++C;
-      if((C==MAXSPRITE1)&&!OPTION(MSX_ALLSPRITE)) break;
-    }
-  }
-  while(L<32);
-
-  /* Draw all marked sprites */
-  for(;M;M>>=1,AT-=4)
-    if(M&1)
-    {
-      C=AT[3];                  /* C = sprite attributes */
-      L=C&0x80? AT[1]-32:AT[1]; /* Sprite may be shifted left by 32 */
-      C&=0x0F;                  /* C = sprite color */
-
-      if((L<256)&&(L>-H)&&C)
+      K=AT[0];                /* K = sprite Y coordinate */
+      if(K>256-H) K-=256;     /* Y coordinate may be negative */
+
+      P=Line+L;
+      PT=SprGen+((int)(H>8? AT[2]&0xFC:AT[2])<<3)+Y-K-1;
+      C=XPal[C];
+
+      /* Mask 1: clip left sprite boundary */
+      K=L>=0? 0x0FFFF:(0x10000>>-L)-1;
+      /* Mask 2: clip right sprite boundary */
+      if(L>256-H) K^=((0x00200>>(H-8))<<(L-257+H))-1;
+      /* Get and clip the sprite data */
+      K&=((int)PT[0]<<8)|(H>8? PT[16]:0x00);
+
+      /* Draw left 8 pixels of the sprite */
+      if(K&0xFF00)
       {
-        K=AT[0];                /* K = sprite Y coordinate */
-        if(K>256-H) K-=256;     /* Y coordinate may be negative */
-
-        P=Line+L;
-        PT=SprGen+((int)(H>8? AT[2]&0xFC:AT[2])<<3)+Y-K-1;
-        C=XPal[C];
-
-        /* Mask 1: clip left sprite boundary */
-        K=L>=0? 0x0FFFF:(0x10000>>-L)-1;
-        /* Mask 2: clip right sprite boundary */
-        if(L>256-H) K^=((0x00200>>(H-8))<<(L-257+H))-1;
-        /* Get and clip the sprite data */
-        K&=((int)PT[0]<<8)|(H>8? PT[16]:0x00);
-
-        /* Draw left 8 pixels of the sprite */
-        if(K&0xFF00)
-        {
-          if(K&0x8000) P[0]=C;if(K&0x4000) P[1]=C;
-          if(K&0x2000) P[2]=C;if(K&0x1000) P[3]=C;
-          if(K&0x0800) P[4]=C;if(K&0x0400) P[5]=C;
-          if(K&0x0200) P[6]=C;if(K&0x0100) P[7]=C;
-        }
+        if(K&0x8000) P[0]=C;if(K&0x4000) P[1]=C;
+        if(K&0x2000) P[2]=C;if(K&0x1000) P[3]=C;
+        if(K&0x0800) P[4]=C;if(K&0x0400) P[5]=C;
+        if(K&0x0200) P[6]=C;if(K&0x0100) P[7]=C;
+      }
 
-        /* Draw right 8 pixels of the sprite */
-        if(K&0x00FF)
-        {
-          if(K&0x0080) P[8]=C; if(K&0x0040) P[9]=C;
-          if(K&0x0020) P[10]=C;if(K&0x0010) P[11]=C;
-          if(K&0x0008) P[12]=C;if(K&0x0004) P[13]=C;
-          if(K&0x0002) P[14]=C;if(K&0x0001) P[15]=C;
-        }
+      /* Draw right 8 pixels of the sprite */
+      if(K&0x00FF)
+      {
+        if(K&0x0080) P[8]=C; if(K&0x0040) P[9]=C;
+        if(K&0x0020) P[10]=C;if(K&0x0010) P[11]=C;
+        if(K&0x0008) P[12]=C;if(K&0x0004) P[13]=C;
+        if(K&0x0002) P[14]=C;if(K&0x0001) P[15]=C;
       }
     }
+  }
 }
 
 /** ColorSprites() *******************************************/
 /** This function is called from RefreshLine#() to refresh  **/
 /** color sprites in SCREENs 4-8. The result is returned in **/
-/** ZBuf, whose size must be 304 bytes (32+256+16).         **/
+/** ZBuf, whose size must be 304 bytes (32+256+16). Returns **/
+/** the number of sprites drawn. When it returns 0, ZBuf is **/
+/** left untouched and must not be used.                    **/
 /*************************************************************/
-void ColorSprites(register byte Y,byte *ZBuf)
+int ColorSprites(register byte Y,byte *ZBuf)
 {
   register byte C,H,J,OrThem;
-  register byte *P,*PT,*AT;
-  register int L,K;
-  register unsigned int M;
+  register byte *P,*PT,*AT,*S;
+  register int K,L,N;
 
-  /* Clear ZBuffer and exit if sprites are off */
-  memset(ZBuf+32,0,256);
-  if(SpritesOFF) return;
+  /* Exit if sprites are off */
+  if(SpritesOFF) return(0);
 
-  /* Assign initial values before counting */
+  /* Find sprites in this line, up to MAXSPRITE2 sprites */
   H=Sprites16x16? 16:8;
-  C=0;M=0;L=0;
-  AT=SprTab-4;
+  S=SpriteLine(Y,216,VScroll);
+  L=S[0];
+  if((L>MAXSPRITE2)&&!OPTION(MSX_ALLSPRITE)) L=MAXSPRITE2;
   OrThem=0x00;
 
-  /* Count displayed sprites */
-  do
+  /* Clear ZBuffer only if there is something to draw */
+  if(!L) return(0);
+  memset(ZBuf+32,0,256);
+
+  /* Draw sprites, the first one on top */
+  for(N=0;L;L--)
   {
-    M<<=1;AT+=4;L++;          /* Iterating through SprTab      */
-    K=AT[0];                  /* Read Y from SprTab            */
-    if(K==216) break;         /* Iteration terminates if Y=216 */
-    K=(byte)(K-VScroll);      /* Sprite's actual Y coordinate  */
-    if(K>256-H) K-=256;       /* Y coordinate may be negative  */
-
-    /* Mark all valid sprites with 1s, break at MAXSPRITE2 sprites */
-    if((Y>K)&&(Y<=K+H))
-    {
-      M|=1;++C;
-      if((C==MAXSPRITE2)&&!OPTION(MSX_ALLSPRITE)) break;
-    }
-  }
-  while(L<32);
+    AT=SprTab+((int)S[L]<<2);
+    K=(byte)(AT[0]-VScroll); /* K = sprite Y coordinate */
+    if(K>256-H) K-=256;      /* Y coordinate may be negative */
 
-  /* Draw all marked sprites */
-  for(;M;M>>=1,AT-=4)
-    if(M&1)
-    {
-      K=(byte)(AT[0]-VScroll); /* K = sprite Y coordinate */
-      if(K>256-H) K-=256;      /* Y coordinate may be negative */
+    J=Y-K-1;
+    C=SprTab[-0x0200+((AT-SprTab)<<2)+J];
+    OrThem|=C&0x40;
 
-      J=Y-K-1;
-      C=SprTab[-0x0200+((AT-SprTab)<<2)+J];
-      OrThem|=C&0x40;
+    if(C&0x0F)
+    {
+      PT=SprGen+((int)(H>8? AT[2]&0xFC:AT[2])<<3)+J;
+      P=ZBuf+AT[1]+(C&0x80? 0:32);
+      C&=0x0F;
+      J=PT[0];
+      N++;
 
-      if(C&0x0F)
+      if(OrThem&0x20)
       {
-        PT=SprGen+((int)(H>8? AT[2]&0xFC:AT[2])<<3)+J;
-        P=ZBuf+AT[1]+(C&0x80? 0:32);
-        C&=0x0F;
-        J=PT[0];
-
-        if(OrThem&0x20)
+        if(J&0x80) P[0]|=C;if(J&0x40) P[1]|=C;
+        if(J&0x20) P[2]|=C;if(J&0x10) P[3]|=C;
+        if(J&0x08) P[4]|=C;if(J&0x04) P[5]|=C;
+        if(J&0x02) P[6]|=C;if(J&0x01) P[7]|=C;
+        if(H>8)
         {
-          if(J&0x80) P[0]|=C;if(J&0x40) P[1]|=C;
-          if(J&0x20) P[2]|=C;if(J&0x10) P[3]|=C;
-          if(J&0x08) P[4]|=C;if(J&0x04) P[5]|=C;
-          if(J&0x02) P[6]|=C;if(J&0x01) P[7]|=C;
-          if(H>8)
-          {
-            J=PT[16];
-            if(J&0x80) P[8]|=C; if(J&0x40) P[9]|=C;
-            if(J&0x20) P[10]|=C;if(J&0x10) P[11]|=C;
-            if(J&0x08) P[12]|=C;if(J&0x04) P[13]|=C;
-            if(J&0x02) P[14]|=C;if(J&0x01) P[15]|=C;
-          }
+          J=PT[16];
+          if(J&0x80) P[8]|=C; if(J&0x40) P[9]|=C;
+          if(J&0x20) P[10]|=C;if(J&0x10) P[11]|=C;
+          if(J&0x08) P[12]|=C;if(J&0x04) P[13]|=C;
+          if(J&0x02) P[14]|=C;if(J&0x01) P[15]|=C;
         }
-        else
+      }
+      else
+      {
+        if(J&0x80) P[0]=C;if(J&0x40) P[1]=C;
+        if(J&0x20) P[2]=C;if(J&0x10) P[3]=C;
+        if(J&0x08) P[4]=C;if(J&0x04) P[5]=C;
+        if(J&0x02) P[6]=C;if(J&0x01) P[7]=C;
+        if(H>8)
         {
-          if(J&0x80) P[0]=C;if(J&0x40) P[1]=C;
-          if(J&0x20) P[2]=C;if(J&0x10) P[3]=C;
-          if(J&0x08) P[4]=C;if(J&0x04) P[5]=C;
-          if(J&0x02) P[6]=C;if(J&0x01) P[7]=C;
-          if(H>8)
-          {
-            J=PT[16];
-            if(J&0x80) P[8]=C; if(J&0x40) P[9]=C;
-            if(J&0x20) P[10]=C;if(J&0x10) P[11]=C;
-            if(J&0x08) P[12]=C;if(J&0x04) P[13]=C;
-            if(J&0x02) P[14]=C;if(J&0x01) P[15]=C;
-          }
+          J=PT[16];
+          if(J&0x80) P[8]=C; if(J&0x40) P[9]=C;
+          if(J&0x20) P[10]=C;if(J&0x10) P[11]=C;
+          if(J&0x08) P[12]=C;if(J&0x04) P[13]=C;
+          if(J&0x02) P[14]=C;if(J&0x01) P[15]=C;
         }
       }
-
-      /* Update overlapping flag */
-      OrThem>>=1;
     }
+
+    /* Update overlapping flag */
+    OrThem>>=1;
+  }
+
+  return(N);
 }
 
 /** RefreshLineF() *******************************************/
@@ -374,7 +478,7 @@ void RefreshLineF(register byte Y)
       ScrMode,ChrTab-VRAM,ChrGen-VRAM,ColTab-VRAM,SprTab-VRAM,SprGen-VRAM
     );
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(P) ClearLine(P,XPal[BGColor]);
 }
 
@@ -383,10 +487,10 @@ void RefreshLineF(register byte Y)
 /*************************************************************/
 void RefreshLine0(register byte Y)
 {
-  register pixel *P,FC,BC;
+  register pixel *P,*Q,FC,BC;
   register byte X,*T,*G;
 
-  BC=XPal[BGColor];
+  BC=XPAL(BGColor);
   P=RefreshBorder(Y,BC);
   if(!P) return;
 
@@ -402,10 +506,9 @@ void RefreshLine0(register byte Y)
 
     for(X=0;X<40;X++,T++,P+=6)
     {
-      Y=G[(int)*T<<3];
-      P[0]=Y&0x80? FC:BC;P[1]=Y&0x40? FC:BC;
-      P[2]=Y&0x20? FC:BC;P[3]=Y&0x10? FC:BC;
-      P[4]=Y&0x08? FC:BC;P[5]=Y&0x04? FC:BC;
+      Q=GetGlyph(G[(int)*T<<3],FC,BC);
+      P[0]=Q[0];P[1]=Q[1];P[2]=Q[2];
+      P[3]=Q[3];P[4]=Q[4];P[5]=Q[5];
     }
 
     P[0]=P[1]=P[2]=P[3]=P[4]=P[5]=P[6]=BC;
@@ -418,10 +521,10 @@ void RefreshLine0(register byte Y)
 /*************************************************************/
 void RefreshLine1(register byte Y)
 {
-  register pixel *P,FC,BC;
+  register pixel *P;
   register byte K,X,*T,*G;
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor]);
@@ -434,13 +537,7 @@ void RefreshLine1(register byte Y)
     for(X=0;X<32;X++,T++,P+=8)
     {
       K=ColTab[*T>>3];
-      FC=XPal[K>>4];
-      BC=XPal[K&0x0F];
-      K=G[(int)*T<<3];
-      P[0]=K&0x80? FC:BC;P[1]=K&0x40? FC:BC;
-      P[2]=K&0x20? FC:BC;P[3]=K&0x10? FC:BC;
-      P[4]=K&0x08? FC:BC;P[5]=K&0x04? FC:BC;
-      P[6]=K&0x02? FC:BC;P[7]=K&0x01? FC:BC;
+      PutGlyph(P,GetGlyph(G[(int)*T<<3],XPal[K>>4],XPal[K&0x0F]));
     }
 
     if(!SpritesOFF) Sprites(Y,P-256);
@@ -453,11 +550,11 @@ void RefreshLine1(register byte Y)
 /*************************************************************/
 void RefreshLine2(register byte Y)
 {
-  register pixel *P,FC,BC;
+  register pixel *P;
   register byte K,X,*T;
   register int I,J;
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor]);
@@ -471,13 +568,7 @@ void RefreshLine2(register byte Y)
     {
       J=(int)*T<<3;
       K=ColTab[(I+J)&ColTabM];
-      FC=XPal[K>>4];
-      BC=XPal[K&0x0F];
-      K=ChrGen[(I+J)&ChrGenM];
-      P[0]=K&0x80? FC:BC;P[1]=K&0x40? FC:BC;
-      P[2]=K&0x20? FC:BC;P[3]=K&0x10? FC:BC;
-      P[4]=K&0x08? FC:BC;P[5]=K&0x04? FC:BC;
-      P[6]=K&0x02? FC:BC;P[7]=K&0x01? FC:BC;
+      PutGlyph(P,GetGlyph(ChrGen[(I+J)&ChrGenM],XPal[K>>4],XPal[K&0x0F]));
     }
 
     if(!SpritesOFF) Sprites(Y,P-256);
@@ -493,7 +584,7 @@ void RefreshLine3(register byte Y)
   register pixel *P;
   register byte X,K,*T,*G;
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor]);
@@ -522,17 +613,17 @@ void RefreshLine4(register byte Y)
 {
   register pixel *P,FC,BC;
   register byte K,X,C,*T,*R;
-  register int I,J;
-  byte ZBuf[304];
+  register int I,J,S;
+  unsigned int ZBuf[304/sizeof(int)];
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     Y+=VScroll;
     T=ChrTab+((int)(Y&0xF8)<<2);
     I=((int)(Y&0xC0)<<5)+(Y&0x07);
@@ -545,6 +636,12 @@ void RefreshLine4(register byte Y)
       BC=XPal[K&0x0F];
       K=ChrGen[(I+J)&ChrGenM];
 
+      if(!S||NOSPR8(R))
+      {
+        PutGlyph(P,GetGlyph(K,FC,BC));
+        continue;
+      }
+
       C=R[0];P[0]=C? XPal[C]:(K&0x80)? FC:BC;
       C=R[1];P[1]=C? XPal[C]:(K&0x40)? FC:BC;
       C=R[2];P[2]=C? XPal[C]:(K&0x20)? FC:BC;
@@ -565,18 +662,48 @@ void RefreshLine5(register byte Y)
 {
   register pixel *P;
   register byte I,X,*T,*R;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int S;
+  unsigned int ZBuf[304/sizeof(int)];
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<7)&ChrTabM&0x7FFF);
 
+    /* Word-wide path: 8 pixels from 4 bytes of VRAM */
+    if(WIDE_OK(P,T))
+    {
+      for(X=0;X<32;X++,R+=8,P+=8,T+=4)
+        if(!S||NOSPR8(R))
+        {
+          Q=(unsigned int *)P;
+          W=*(unsigned int *)T;
+          I=VBYTE(W,0);Q[0]=PIX2(XPal[I>>4],XPal[I&0x0F]);
+          I=VBYTE(W,1);Q[1]=PIX2(XPal[I>>4],XPal[I&0x0F]);
+          I=VBYTE(W,2);Q[2]=PIX2(XPal[I>>4],XPal[I&0x0F]);
+          I=VBYTE(W,3);Q[3]=PIX2(XPal[I>>4],XPal[I&0x0F]);
+        }
+        else
+        {
+          I=R[0];P[0]=XPal[I? I:T[0]>>4];
+          I=R[1];P[1]=XPal[I? I:T[0]&0x0F];
+          I=R[2];P[2]=XPal[I? I:T[1]>>4];
+          I=R[3];P[3]=XPal[I? I:T[1]&0x0F];
+          I=R[4];P[4]=XPal[I? I:T[2]>>4];
+          I=R[5];P[5]=XPal[I? I:T[2]&0x0F];
+          I=R[6];P[6]=XPal[I? I:T[3]>>4];
+          I=R[7];P[7]=XPal[I? I:T[3]&0x0F];
+        }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<16;X++,R+=16,P+=16,T+=8)
     {
       I=R[0];P[0]=XPal[I? I:T[0]>>4];
@@ -612,7 +739,9 @@ void RefreshLine8(register byte Y)
   };
   register pixel *P;
   register byte C,X,*T,*R;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int S;
+  unsigned int ZBuf[304/sizeof(int)];
 
   P=RefreshBorder(Y,BPal[VDP[7]]);
   if(!P) return;
@@ -620,10 +749,39 @@ void RefreshLine8(register byte Y)
   if(!ScreenON) ClearLine(P,BPal[VDP[7]]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<8)&ChrTabM&0xFFFF);
 
+    /* Word-wide path: 8 pixels from 8 bytes of VRAM */
+    if(WIDE_OK(P,T))
+    {
+      for(X=0;X<32;X++,T+=8,R+=8,P+=8)
+        if(!S||NOSPR8(R))
+        {
+          Q=(unsigned int *)P;
+          W=((unsigned int *)T)[0];
+          Q[0]=PIX2(BPal[VBYTE(W,0)],BPal[VBYTE(W,1)]);
+          Q[1]=PIX2(BPal[VBYTE(W,2)],BPal[VBYTE(W,3)]);
+          W=((unsigned int *)T)[1];
+          Q[2]=PIX2(BPal[VBYTE(W,0)],BPal[VBYTE(W,1)]);
+          Q[3]=PIX2(BPal[VBYTE(W,2)],BPal[VBYTE(W,3)]);
+        }
+        else
+        {
+          C=R[0];P[0]=BPal[C? SprToScr[C]:T[0]];
+          C=R[1];P[1]=BPal[C? SprToScr[C]:T[1]];
+          C=R[2];P[2]=BPal[C? SprToScr[C]:T[2]];
+          C=R[3];P[3]=BPal[C? SprToScr[C]:T[3]];
+          C=R[4];P[4]=BPal[C? SprToScr[C]:T[4]];
+          C=R[5];P[5]=BPal[C? SprToScr[C]:T[5]];
+          C=R[6];P[6]=BPal[C? SprToScr[C]:T[6]];
+          C=R[7];P[7]=BPal[C? SprToScr[C]:T[7]];
+        }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<32;X++,T+=8,R+=8,P+=8)
     {
       C=R[0];P[0]=BPal[C? SprToScr[C]:T[0]];
@@ -646,8 +804,9 @@ void RefreshLine10(register byte Y)
 {
   register pixel *P;
   register byte C,X,*T,*R;
-  register int J,K;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int K,S;
+  unsigned int ZBuf[304/sizeof(int)];
 
   P=RefreshBorder(Y,BPal[VDP[7]]);
   if(!P) return;
@@ -655,8 +814,9 @@ void RefreshLine10(register byte Y)
   if(!ScreenON) ClearLine(P,BPal[VDP[7]]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    if(!YJKReady) BuildYJK();
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<8)&ChrTabM&0xFFFF);
 
     /* Draw first 4 pixels */
@@ -666,17 +826,46 @@ void RefreshLine10(register byte Y)
     C=R[3];P[3]=C? XPal[C]:BPal[VDP[7]];
     R+=4;P+=4;
 
+    /* Word-wide path: one YJK block per 32bit load */
+    if(WIDE_OK(P,T))
+    {
+      register pixel P0,P1,P2,P3;
+
+      for(X=0;X<63;X++,T+=4,R+=4,P+=4)
+      {
+        W=*(unsigned int *)T;
+        K=(VBYTE(W,0)&0x07)|((VBYTE(W,1)&0x07)<<3)
+         |((VBYTE(W,2)&0x07)<<6)|((VBYTE(W,3)&0x07)<<9);
+
+        Y=VBYTE(W,0)>>3;P0=Y&1? XPal[Y>>1]:YJK(Y,K);
+        Y=VBYTE(W,1)>>3;P1=Y&1? XPal[Y>>1]:YJK(Y,K);
+        Y=VBYTE(W,2)>>3;P2=Y&1? XPal[Y>>1]:YJK(Y,K);
+        Y=VBYTE(W,3)>>3;P3=Y&1? XPal[Y>>1]:YJK(Y,K);
+
+        if(S&&!NOSPR4(R))
+        {
+          if((C=R[0])) P0=XPal[C];
+          if((C=R[1])) P1=XPal[C];
+          if((C=R[2])) P2=XPal[C];
+          if((C=R[3])) P3=XPal[C];
+        }
+
+        Q=(unsigned int *)P;
+        Q[0]=PIX2(P0,P1);
+        Q[1]=PIX2(P2,P3);
+      }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<63;X++,T+=4,R+=4,P+=4)
     {
-      K=(T[0]&0x07)|((T[1]&0x07)<<3);
-      if(K&0x20) K-=64;
-      J=(T[2]&0x07)|((T[3]&0x07)<<3);
-      if(J&0x20) J-=64;
-
-      C=R[0];Y=T[0]>>3;P[0]=C? XPal[C]:Y&1? XPal[Y>>1]:YJKColor(Y,J,K);
-      C=R[1];Y=T[1]>>3;P[1]=C? XPal[C]:Y&1? XPal[Y>>1]:YJKColor(Y,J,K);
-      C=R[2];Y=T[2]>>3;P[2]=C? XPal[C]:Y&1? XPal[Y>>1]:YJKColor(Y,J,K);
-      C=R[3];Y=T[3]>>3;P[3]=C? XPal[C]:Y&1? XPal[Y>>1]:YJKColor(Y,J,K);
+      K=(T[0]&0x07)|((T[1]&0x07)<<3)|((T[2]&0x07)<<6)|((T[3]&0x07)<<9);
+
+      C=R[0];Y=T[0]>>3;P[0]=C? XPal[C]:Y&1? XPal[Y>>1]:YJK(Y,K);
+      C=R[1];Y=T[1]>>3;P[1]=C? XPal[C]:Y&1? XPal[Y>>1]:YJK(Y,K);
+      C=R[2];Y=T[2]>>3;P[2]=C? XPal[C]:Y&1? XPal[Y>>1]:YJK(Y,K);
+      C=R[3];Y=T[3]>>3;P[3]=C? XPal[C]:Y&1? XPal[Y>>1]:YJK(Y,K);
     }
   }
 }
@@ -689,8 +878,9 @@ void RefreshLine12(register byte Y)
 {
   register pixel *P;
   register byte C,X,*T,*R;
-  register int J,K;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int K,S;
+  unsigned int ZBuf[304/sizeof(int)];
 
   P=RefreshBorder(Y,BPal[VDP[7]]);
   if(!P) return;
@@ -698,8 +888,9 @@ void RefreshLine12(register byte Y)
   if(!ScreenON) ClearLine(P,BPal[VDP[7]]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    if(!YJKReady) BuildYJK();
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<8)&ChrTabM&0xFFFF);
 
     if(HScroll512&&(HScroll>255)) T=(byte *)((int)T^0x10000);
@@ -712,17 +903,46 @@ void RefreshLine12(register byte Y)
     C=R[3];P[3]=C? XPal[C]:BPal[VDP[7]];
     R+=4;P+=4;
 
+    /* Word-wide path: one YJK block per 32bit load */
+    if(WIDE_OK(P,T))
+    {
+      register pixel P0,P1,P2,P3;
+
+      for(X=1;X<64;X++,T+=4,R+=4,P+=4)
+      {
+        W=*(unsigned int *)T;
+        K=(VBYTE(W,0)&0x07)|((VBYTE(W,1)&0x07)<<3)
+         |((VBYTE(W,2)&0x07)<<6)|((VBYTE(W,3)&0x07)<<9);
+
+        P0=YJK(VBYTE(W,0)>>3,K);
+        P1=YJK(VBYTE(W,1)>>3,K);
+        P2=YJK(VBYTE(W,2)>>3,K);
+        P3=YJK(VBYTE(W,3)>>3,K);
+
+        if(S&&!NOSPR4(R))
+        {
+          if((C=R[0])) P0=XPal[C];
+          if((C=R[1])) P1=XPal[C];
+          if((C=R[2])) P2=XPal[C];
+          if((C=R[3])) P3=XPal[C];
+        }
+
+        Q=(unsigned int *)P;
+        Q[0]=PIX2(P0,P1);
+        Q[1]=PIX2(P2,P3);
+      }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=1;X<64;X++,T+=4,R+=4,P+=4)
     {
-      K=(T[0]&0x07)|((T[1]&0x07)<<3);
-      if(K&0x20) K-=64;
-      J=(T[2]&0x07)|((T[3]&0x07)<<3);
-      if(J&0x20) J-=64;
-
-      C=R[0];P[0]=C? XPal[C]:YJKColor(T[0]>>3,J,K);
-      C=R[1];P[1]=C? XPal[C]:YJKColor(T[1]>>3,J,K);
-      C=R[2];P[2]=C? XPal[C]:YJKColor(T[2]>>3,J,K);
-      C=R[3];P[3]=C? XPal[C]:YJKColor(T[3]>>3,J,K);
+      K=(T[0]&0x07)|((T[1]&0x07)<<3)|((T[2]&0x07)<<6)|((T[3]&0x07)<<9);
+
+      C=R[0];P[0]=C? XPal[C]:YJK(T[0]>>3,K);
+      C=R[1];P[1]=C? XPal[C]:YJK(T[1]>>3,K);
+      C=R[2];P[2]=C? XPal[C]:YJK(T[2]>>3,K);
+      C=R[3];P[3]=C? XPal[C]:YJK(T[3]>>3,K);
     }
   }
 }
@@ -737,18 +957,48 @@ void RefreshLine6(register byte Y)
 
   register pixel *P;
   register byte X,*T,*R,C;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int S;
+  unsigned int ZBuf[304/sizeof(int)];
 
-  P=RefreshBorder(Y,XPal[BGColor&0x03]);
+  P=RefreshBorder(Y,XPAL(BGColor&0x03));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor&0x03]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<7)&ChrTabM&0x7FFF);
 
+    /* Word-wide path: 8 pixels from 4 bytes of VRAM */
+    if(WIDE_OK(P,T))
+    {
+      for(X=0;X<32;X++,R+=8,P+=8,T+=4)
+        if(!S||NOSPR8(R))
+        {
+          Q=(unsigned int *)P;
+          W=*(unsigned int *)T;
+          C=VBYTE(W,0);Q[0]=PIX2(XPal[C>>6],XPal[(C>>2)&0x03]);
+          C=VBYTE(W,1);Q[1]=PIX2(XPal[C>>6],XPal[(C>>2)&0x03]);
+          C=VBYTE(W,2);Q[2]=PIX2(XPal[C>>6],XPal[(C>>2)&0x03]);
+          C=VBYTE(W,3);Q[3]=PIX2(XPal[C>>6],XPal[(C>>2)&0x03]);
+        }
+        else
+        {
+          C=R[0];P[0]=XPal[C? C:T[0]>>6];
+          C=R[1];P[1]=XPal[C? C:(T[0]>>2)&0x03];
+          C=R[2];P[2]=XPal[C? C:T[1]>>6];
+          C=R[3];P[3]=XPal[C? C:(T[1]>>2)&0x03];
+          C=R[4];P[4]=XPal[C? C:T[2]>>6];
+          C=R[5];P[5]=XPal[C? C:(T[2]>>2)&0x03];
+          C=R[6];P[6]=XPal[C? C:T[3]>>6];
+          C=R[7];P[7]=XPal[C? C:(T[3]>>2)&0x03];
+        }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<32;X++)
     {
       C=R[0];P[0]=XPal[C? C:T[0]>>6];
@@ -774,18 +1024,49 @@ void RefreshLine7(register byte Y)
 
   register pixel *P;
   register byte C,X,*T,*R;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int S;
+  unsigned int ZBuf[304/sizeof(int)];
 
-  P=RefreshBorder(Y,XPal[BGColor]);
+  P=RefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) ClearLine(P,XPal[BGColor]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<8)&ChrTabM&0xFFFF);
 
+    /* Word-wide path: 8 pixels from 8 bytes of VRAM */
+    if(WIDE_OK(P,T))
+    {
+      for(X=0;X<32;X++,R+=8,P+=8,T+=8)
+        if(!S||NOSPR8(R))
+        {
+          Q=(unsigned int *)P;
+          W=((unsigned int *)T)[0];
+          Q[0]=PIX2(XPal[VBYTE(W,0)>>4],XPal[VBYTE(W,1)>>4]);
+          Q[1]=PIX2(XPal[VBYTE(W,2)>>4],XPal[VBYTE(W,3)>>4]);
+          W=((unsigned int *)T)[1];
+          Q[2]=PIX2(XPal[VBYTE(W,0)>>4],XPal[VBYTE(W,1)>>4]);
+          Q[3]=PIX2(XPal[VBYTE(W,2)>>4],XPal[VBYTE(W,3)>>4]);
+        }
+        else
+        {
+          C=R[0];P[0]=XPal[C? C:T[0]>>4];
+          C=R[1];P[1]=XPal[C? C:T[1]>>4];
+          C=R[2];P[2]=XPal[C? C:T[2]>>4];
+          C=R[3];P[3]=XPal[C? C:T[3]>>4];
+          C=R[4];P[4]=XPal[C? C:T[4]>>4];
+          C=R[5];P[5]=XPal[C? C:T[5]>>4];
+          C=R[6];P[6]=XPal[C? C:T[6]>>4];
+          C=R[7];P[7]=XPal[C? C:T[7]>>4];
+        }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<32;X++)
     {
       C=R[0];P[0]=XPal[C? C:T[0]>>4];
@@ -811,7 +1092,7 @@ void RefreshLineTx80(register byte Y)
   register pixel *P,FC,BC;
   register byte X,M,*T,*C,*G;
 
-  BC=XPal[BGColor];
+  BC=XPAL(BGColor);
   P=RefreshBorder(Y,BC);
   if(!P) return;
 
@@ -848,18 +1129,64 @@ void HiResRefreshLine6(register byte Y)
 {
   register pixel *P;
   register byte X,*T,*R,C;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int S;
+  unsigned int ZBuf[304/sizeof(int)];
 
-  P=HiResRefreshBorder(Y,XPal[BGColor&0x03]);
+  P=HiResRefreshBorder(Y,XPAL(BGColor&0x03));
   if(!P) return;
 
   if(!ScreenON) HiResClearLine(P,XPal[BGColor&0x03]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<7)&ChrTabM&0x7FFF);
 
+    /* Word-wide path: 16 pixels from 4 bytes of VRAM */
+    if(WIDE_OK(P,T))
+    {
+      for(X=0;X<32;X++,R+=8,P+=16,T+=4)
+        if(!S||NOSPR8(R))
+        {
+          Q=(unsigned int *)P;
+          W=*(unsigned int *)T;
+          C=VBYTE(W,0);
+          Q[0]=PIX2(XPal[C>>6],XPal[(C>>4)&0x03]);
+          Q[1]=PIX2(XPal[(C>>2)&0x03],XPal[C&0x03]);
+          C=VBYTE(W,1);
+          Q[2]=PIX2(XPal[C>>6],XPal[(C>>4)&0x03]);
+          Q[3]=PIX2(XPal[(C>>2)&0x03],XPal[C&0x03]);
+          C=VBYTE(W,2);
+          Q[4]=PIX2(XPal[C>>6],XPal[(C>>4)&0x03]);
+          Q[5]=PIX2(XPal[(C>>2)&0x03],XPal[C&0x03]);
+          C=VBYTE(W,3);
+          Q[6]=PIX2(XPal[C>>6],XPal[(C>>4)&0x03]);
+          Q[7]=PIX2(XPal[(C>>2)&0x03],XPal[C&0x03]);
+        }
+        else
+        {
+          C=R[0];P[0] =XPal[C? C: T[0]>>6];
+          C=R[0];P[1] =XPal[C? C:(T[0]>>4)&0x03];
+          C=R[1];P[2] =XPal[C? C:(T[0]>>2)&0x03];
+          C=R[1];P[3] =XPal[C? C: T[0]&0x03];
+          C=R[2];P[4] =XPal[C? C: T[1]>>6];
+          C=R[2];P[5] =XPal[C? C:(T[1]>>4)&0x03];
+          C=R[3];P[6] =XPal[C? C:(T[1]>>2)&0x03];
+          C=R[3];P[7] =XPal[C? C: T[1]&0x03];
+          C=R[4];P[8] =XPal[C? C: T[2]>>6];
+          C=R[4];P[9] =XPal[C? C:(T[2]>>4)&0x03];
+          C=R[5];P[10]=XPal[C? C:(T[2]>>2)&0x03];
+          C=R[5];P[11]=XPal[C? C: T[2]&0x03];
+          C=R[6];P[12]=XPal[C? C: T[3]>>6];
+          C=R[6];P[13]=XPal[C? C:(T[3]>>4)&0x03];
+          C=R[7];P[14]=XPal[C? C:(T[3]>>2)&0x03];
+          C=R[7];P[15]=XPal[C? C: T[3]&0x03];
+        }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<32;X++)
     {
       C=R[0];P[0] =XPal[C? C: T[0]>>6];
@@ -891,18 +1218,61 @@ void HiResRefreshLine7(register byte Y)
 {
   register pixel *P;
   register byte C,X,*T,*R;
-  byte ZBuf[304];
+  register unsigned int *Q,W;
+  register int S;
+  unsigned int ZBuf[304/sizeof(int)];
 
-  P=HiResRefreshBorder(Y,XPal[BGColor]);
+  P=HiResRefreshBorder(Y,XPAL(BGColor));
   if(!P) return;
 
   if(!ScreenON) HiResClearLine(P,XPal[BGColor]);
   else
   {
-    ColorSprites(Y,ZBuf);
-    R=ZBuf+32;
+    S=ColorSprites(Y,(byte *)ZBuf);
+    R=(byte *)(S? ZBuf:NoSprites)+32;
     T=ChrTab+(((int)(Y+VScroll)<<8)&ChrTabM&0xFFFF);
 
+    /* Word-wide path: 16 pixels from 8 bytes of VRAM */
+    if(WIDE_OK(P,T))
+    {
+      for(X=0;X<32;X++,R+=8,P+=16,T+=8)
+        if(!S||NOSPR8(R))
+        {
+          Q=(unsigned int *)P;
+          W=((unsigned int *)T)[0];
+          C=VBYTE(W,0);Q[0]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          C=VBYTE(W,1);Q[1]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          C=VBYTE(W,2);Q[2]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          C=VBYTE(W,3);Q[3]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          W=((unsigned int *)T)[1];
+          C=VBYTE(W,0);Q[4]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          C=VBYTE(W,1);Q[5]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          C=VBYTE(W,2);Q[6]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+          C=VBYTE(W,3);Q[7]=PIX2(XPal[C>>4],XPal[C&0x0F]);
+        }
+        else
+        {
+          C=R[0];P[0] =XPal[C? C:T[0]>>4];
+          C=R[0];P[1] =XPal[C? C:T[0]&0x0F];
+          C=R[1];P[2] =XPal[C? C:T[1]>>4];
+          C=R[1];P[3] =XPal[C? C:T[1]&0x0F];
+          C=R[2];P[4] =XPal[C? C:T[2]>>4];
+          C=R[2];P[5] =XPal[C? C:T[2]&0x0F];
+          C=R[3];P[6] =XPal[C? C:T[3]>>4];
+          C=R[3];P[7] =XPal[C? C:T[3]&0x0F];
+          C=R[4];P[8] =XPal[C? C:T[4]>>4];
+          C=R[4];P[9] =XPal[C? C:T[4]&0x0F];
+          C=R[5];P[10]=XPal[C? C:T[5]>>4];
+          C=R[5];P[11]=XPal[C? C:T[5]&0x0F];
+          C=R[6];P[12]=XPal[C? C:T[6]>>4];
+          C=R[6];P[13]=XPal[C? C:T[6]&0x0F];
+          C=R[7];P[14]=XPal[C? C:T[7]>>4];
+          C=R[7];P[15]=XPal[C? C:T[7]&0x0F];
+        }
+      return;
+    }
+
+    /* Reference per-pixel path */
     for(X=0;X<32;X++,R+=8,P+=16,T+=8)
     {
       C=R[0];P[0] =XPal[C? C:T[0]>>4];
@@ -930,10 +1300,10 @@ void HiResRefreshLine7(register byte Y)
 /*************************************************************/
 void HiResRefreshLineTx80(register byte Y)
 {
-  register pixel *P,FC,BC;
+  register pixel *P,*Q,FC,BC;
   register byte X,M,*T,*C,*G;
 
-  BC=XPal[BGColor];
+  BC=XPAL(BGColor);
   P=HiResRefreshBorder(Y,BC);
   if(!P) return;
 
@@ -953,10 +1323,9 @@ void HiResRefreshLineTx80(register byte Y)
       if(M&0x80) { FC=XPal[XFGColor];BC=XPal[XBGColor]; }
       else       { FC=XPal[FGColor];BC=XPal[BGColor]; }
       M<<=1;
-      Y=*(G+((int)*T<<3));
-      P[0]=Y&0x80? FC:BC;P[1]=Y&0x40? FC:BC;
-      P[2]=Y&0x20? FC:BC;P[3]=Y&0x10? FC:BC;
-      P[4]=Y&0x08? FC:BC;P[5]=Y&0x04? FC:BC;
+      Q=GetGlyph(G[(int)*T<<3],FC,BC);
+      P[0]=Q[0];P[1]=Q[1];P[2]=Q[2];
+      P[3]=Q[3];P[4]=Q[4];P[5]=Q[5];
     }
 
     P[0]=P[1]=P[2]=P[3]=P[4]=P[5]=P[6]=
@@ -65,6 +65,7 @@ extern int Use8950;    /* MSX-AUDIO emulation (1-yes) */
 int  Mode        = MSX_MSX2|MSX_NTSC|MSX_GUESSA|MSX_GUESSB;
 byte Verbose     = 1;              /* Debug msgs ON/OFF      */
 byte UPeriod     = 75;             /* % of frames to draw    */
+int  ScreenPage  = 0;              /* Screen buffer drawn    */
 int  VPeriod     = CPU_VPERIOD;    /* CPU cycles per VBlank  */
 int  HPeriod     = CPU_HPERIOD;    /* CPU cycles per HBlank  */
 int  RAMPages    = 4;              /* Number of RAM pages    */
@@ -73,6 +74,9 @@ byte ExitNow     = 0;              /* 1 = Exit the emulator  */
 
 /** Main hardware: CPU, RAM, VRAM, mappers *******************/
 Z80 CPU;                           /* Z80 CPU state and regs */
+#ifdef ALTSOUND
+static unsigned int CPUCycles = 0; /* Cycles before IPeriod  */
+#endif
 
 byte *VRAM,*VPAGE;                 /* Video RAM              */
 
@@ -189,6 +193,27 @@ byte PLatch;                       /* Palette buffer         */
 byte ALatch;                       /* Address buffer         */
 int  Palette[16];                  /* Current palette        */
 
+/** Sprite line lists ****************************************/
+static byte SprLines[256][33];     /* Count + sprites/line   */
+static byte *SprLTab;              /* SprTab lists built for */
+static byte SprLStop,SprLH,SprLOff;/* Stop Y, height, offset */
+static byte SprLDirty = 1;         /* 1: rebuild lists       */
+
+/** Dirty line tracking **************************************/
+static unsigned int VRAMGen[64];   /* Writes to 2kB blocks   */
+static unsigned int LineSig[2][256][2]; /* For each ScreenPage */
+static unsigned int ScreenGen = 1; /* Bumped to redraw all   */
+static unsigned int LineMask[2];   /* Blocks read by a line  */
+
+/** Deferred rendering ***************************************/
+static unsigned int PendLines[8];  /* Lines waiting to render*/
+static unsigned int PendMask[2];   /* Blocks they read       */
+static int PendFirst = -1;         /* First pending, -1=none */
+static int PendLast;               /* Last pending line      */
+
+/* VDP registers affecting rendering, see DirtyLine() */
+#define RENDER_REGS 0x0E843FFF
+
 /** Places in DiskROM to be patched with ED FE C9 ************/
 static const word DiskPatches[] =
 { 0x4010,0x4013,0x4016,0x401C,0x401F,0 };
@@ -301,7 +326,9 @@ void SSlot(byte V);               /* Switch secondary slots          */
 void VDPOut(byte R,byte V);       /* Write value into a VDP register */
 void Printer(byte V);             /* Send a character to a printer   */
 void PPIOut(byte New,byte Old);   /* Set PPI bits (key click, etc.)  */
-void CheckSprites(void);          /* Check collisions and 5th sprite */
+void CheckSprites(byte Y);        /* Check collisions and 5th sprite */
+int  DirtyLine(byte Y);           /* 1: line Y must be redrawn       */
+void RenderLine(byte Y);          /* Draw line Y in current mode     */
 byte RTCIn(byte R);               /* Read RTC registers              */
 byte SetScreen(void);             /* Change screen mode              */
 word SetIRQ(byte IRQ);            /* Set/Reset IRQ                   */
@@ -980,6 +1007,7 @@ int ResetMSX(int NewMode,int NewRAMPages,int NewVRAMPages)
     Palette[J]=PalInit[J];
     SetColor(J,(Palette[J]>>16)&0xFF,(Palette[J]>>8)&0xFF,Palette[J]&0xFF);
   }
+  InvalidateScreen();
 
   /* Reset mouse coordinates/counters */
   for(J=0;J<2;++J)
@@ -997,6 +1025,7 @@ int ResetMSX(int NewMode,int NewRAMPages,int NewVRAMPages)
   ScrMode=0;                            /* Screen mode      */
   VKey=PKey=1;WKey=0;                   /* VDP keys         */
   VAddr=0x0000;                         /* VRAM access addr */
+  TouchVRAM(0,VRAMPages*0x4000);        /* VRAM has changed */
   ScanLine=0;                           /* Current scanline */
   VDPData=NORAM;                        /* VDP data buffer  */
   JoyState=0;                           /* Joystick state   */
@@ -1271,7 +1300,12 @@ void OutZ80(word Port,byte Value)
 
 #ifdef ALTSOUND
 case 0x7C: if (Use2413) OPLL.Latch=Value; return;              /* OPLL Register# */
-case 0x7D: if (Use2413) WriteOPLL(OPLL.Latch,Value);return;    /* OPLL Data      */
+case 0x7D: /* OPLL Data */
+  if (!Use2413) return;
+  /* EMULib OPLL is kept current too, for SND_FAST */
+  Write2413(&OPLL,OPLL.Latch&0x3F,Value);
+  WriteOPLL(OPLL.Latch,Value);
+  return;
 case 0xA0: PSG.Latch=Value;return;                             /* PSG Register#  */
 case 0xC0: if (Use8950) WriteAUDIO(0,Value);return;            /* AUDIO Register#*/
 case 0xC1: if (Use8950) WriteAUDIO(1,Value);return;            /* AUDIO Data     */
@@ -1311,7 +1345,9 @@ case 0x98: /* VDP Data */
   if(WKey)
   {
     /* VDP set for writing */
+    FlushVRAM(VPAGE-VRAM+VAddr,1);
     VDPData=VPAGE[VAddr]=Value;
+    TouchVRAM(VPAGE-VRAM+VAddr,1);
     VAddr=(VAddr+1)&0x3FFF;
   }
   else
@@ -1319,7 +1355,9 @@ case 0x98: /* VDP Data */
     /* VDP set for reading */
     VDPData=VPAGE[VAddr];
     VAddr=(VAddr+1)&0x3FFF;
+    FlushVRAM(VPAGE-VRAM+VAddr,1);
     VPAGE[VAddr]=Value;
+    TouchVRAM(VPAGE-VRAM+VAddr,1);
   }
   /* If VAddr rolled over, modify VRAM page# */
   if(!VAddr&&(ScrMode>3)) 
@@ -1376,7 +1414,9 @@ case 0x9A: /* VDP Palette Latch */
     B=(PLatch&0x07)*255/7;
     /* Set new color for palette entry J */
     Palette[J]=RGB2INT(R,G,B);
+    FlushLines();
     SetColor(J,R,G,B);
+    InvalidateScreen();
     /* Next palette entry */
     VDP[16]=(J+1)&0x0F;
   }
@@ -1410,6 +1450,7 @@ case 0xA1: /* PSG Data */
 
   /* Put value into a register */
 #ifdef ALTSOUND
+  if(PSG.Latch<16) Write8910(&PSG,PSG.Latch,Value);
   WritePSG(PSG.Latch,Value);
 #else
   WrData8910(&PSG,Value);
@@ -1511,6 +1552,12 @@ printf("(%04Xh) = %02Xh at PC=%04Xh\n",A,V,CPU.PC.W);
    if((A&0xFF00)==0x9800 || (A&0xFF00)==0xB800)
    {
          Write2212(A,V);
+         /* Keep EMULib SCC current, for SoundQuality=SND_FAST */
+         if(SCCOn[I])
+         {
+           if((A&0xFF00)==0x9800) WriteSCC(&SCChip,A&0xFF,V);
+           else WriteSCCP(&SCChip,A&0xFF,V);
+         }
          return;
    }
 #endif
@@ -1949,6 +1996,9 @@ void VDPOut(register byte R,register byte V)
 { 
   register byte J;
 
+  /* Pending lines must be drawn with the old register value */
+  if((R<28)&&(VDP[R]!=V)&&(RENDER_REGS&(1<<R))) FlushLines();
+
   switch(R)  
   {
     case  0: /* Reset HBlank interrupt if disabled */
@@ -2080,6 +2130,17 @@ byte RTCIn(register byte R)
   return(J|0xF0);
 }
 
+#ifdef ALTSOUND
+/** SoundClock() *********************************************/
+/** Return emulated CPU cycles elapsed. Used to timestamp   **/
+/** sound register writes.                                  **/
+/*************************************************************/
+unsigned int SoundClock(void)
+{
+  return(CPUCycles+CPU.IPeriod-CPU.ICount);
+}
+#endif
+
 /** LoopZ80() ************************************************/
 /** Refresh screen, check keyboard and sprites. Call this   **/
 /** function on each interrupt.                             **/
@@ -2093,6 +2154,11 @@ word LoopZ80(Z80 *R)
   static byte Drawing=0;
   register int J;
 
+#ifdef ALTSOUND
+  /* Count cycles of the period that just ended */
+  CPUCycles+=R->IPeriod;
+#endif
+
   /* Flip HRefresh bit */
   VDPStatus[2]^=0x20;
 
@@ -2114,7 +2180,11 @@ word LoopZ80(Z80 *R)
       /* Reset VRefresh bit */
       VDPStatus[2]&=0xBF;
 
+      /* Reset 5Sprites bit and 5thSprite number for the new frame */
+      VDPStatus[0]=(VDPStatus[0]&0xBF)|0x1F;
+
       /* Refresh display */
+      FlushLines();
       if(UCount>=100) { UCount-=100;RefreshScreen(); }
       UCount+=UPeriod;
 
@@ -2205,23 +2275,27 @@ word LoopZ80(Z80 *R)
   /* Run V9938 engine */
   LoopVDP();
 
-  /* Refresh scanline, possibly with the overscan */
-  if((UCount>=100)&&Drawing&&(ScanLine<256))
+  /* Check sprites and set Collision, 5Sprites, 5thSprite bits */
+  if(Drawing&&ScreenON&&!SpritesOFF&&ScrMode&&(ScrMode<MAXSCREEN+1))
+    CheckSprites(ScanLine);
+
+  /* Queue scanline for refresh, possibly with the overscan */
+  if((UCount>=100)&&Drawing&&(ScanLine<256)&&DirtyLine(ScanLine))
   {
-    if(!ModeYJK||(ScrMode<7)||(ScrMode>8))
-      (RefreshLine[ScrMode])(ScanLine);
-    else
-      if(ModeYAE) RefreshLine10(ScanLine);
-      else RefreshLine12(ScanLine);
+    if(PendFirst<0) PendFirst=ScanLine;
+    PendLast=ScanLine;
+    PendLines[ScanLine>>5]|=1<<(ScanLine&31);
+    PendMask[0]|=LineMask[0];
+    PendMask[1]|=LineMask[1];
   }
 
+  /* Draw queued scanlines when done with the screen */
+  if(!Drawing||(ScanLine==192)) FlushLines();
+
   /* Keyboard, sound, and other stuff always runs at line 192    */
   /* This way, it can't be shut off by overscan tricks (Maarten) */
   if(ScanLine==192)
   {
-    /* Check sprites and set Collision, 5Sprites, 5thSprite bits */
-    if(!SpritesOFF&&ScrMode&&(ScrMode<MAXSCREEN+1)) CheckSprites();
-
     /* Count MIDI ticks */
     MIDITicks(VPeriod/CPU_CLOCK);
 
@@ -2298,75 +2372,279 @@ word LoopZ80(Z80 *R)
 }
 
 /** CheckSprites() *******************************************/
-/** Check for sprite collisions and 5th/9th sprite in a     **/
-/** row.                                                    **/
+/** Check for sprite collisions and 5th/9th sprite in line  **/
+/** Y. Patterns of displayed sprites are ORed into a line   **/
+/** bitmask, a collision is found when a sprite overlaps    **/
+/** bits already set.                                       **/
 /*************************************************************/
-void CheckSprites(void)
+void CheckSprites(register byte Y)
 {
-  register word LS,LD;
-  register byte DH,DV,*PS,*PD,*T;
-  byte I,J,N,M,*S,*D;
+  unsigned int Mask[10];
+  register unsigned int M,A,B;
+  register byte *S,*AT,*PT,C,H;
+  register int J,K,N,X;
 
-  /* Clear 5Sprites, Collision, and 5thSprite bits */
-  VDPStatus[0]=(VDPStatus[0]&0x9F)|0x1F;
+  H=Sprites16x16? 16:8;
 
-  for(N=0,S=SprTab;(N<32)&&(S[0]!=208);N++,S+=4);
-  M=SolidColor0;
+  /* Get sprites crossing this line */
+  if(ScrMode<4) { Y+=VScroll;S=SpriteLine(Y,208,0);K=MAXSPRITE1; }
+  else          { S=SpriteLine(Y,216,VScroll);K=MAXSPRITE2; }
+  N=S[0];
 
-  if(Sprites16x16)
+  /* Too many sprites: report the first one not displayed */
+  if(N>K)
   {
-    for(J=0,S=SprTab;J<N;++J,S+=4)
-      if((S[3]&0x0F)||M)
-        for(I=J+1,D=S+4;I<N;++I,D+=4)
-          if((D[3]&0x0F)||M) 
-          {
-            DV=S[0]-D[0];
-            if((DV<16)||(DV>240))
-	    {
-              DH=S[1]-D[1];
-              if((DH<16)||(DH>240))
-	      {
-                PS=SprGen+((int)(S[2]&0xFC)<<3);
-                PD=SprGen+((int)(D[2]&0xFC)<<3);
-                if(DV<16) PD+=DV; else { DV=256-DV;PS+=DV; }
-                if(DH>240) { DH=256-DH;T=PS;PS=PD;PD=T; }
-                while(DV<16)
-                {
-                  LS=((word)*PS<<8)+*(PS+16);
-                  LD=((word)*PD<<8)+*(PD+16);
-                  if(LD&(LS>>DH)) break;
-                  else { DV++;PS++;PD++; }
-                }
-                if(DV<16) { VDPStatus[0]|=0x20;return; }
-              }
-            }
-          }
+    if(!(VDPStatus[0]&0x40))
+      VDPStatus[0]=(VDPStatus[0]&0xA0)|0x40|S[K+1];
+    N=K;
   }
-  else
+
+  /* Collision already reported or not possible */
+  if((VDPStatus[0]&0x20)||(N<2)) return;
+
+  /* Bits 32..287 of the mask correspond to screen pixels 0..255 */
+  for(J=0;J<10;J++) Mask[J]=0;
+
+  for(J=1;J<=N;J++)
   {
-    for(J=0,S=SprTab;J<N;++J,S+=4)
-      if((S[3]&0x0F)||M)
-        for(I=J+1,D=S+4;I<N;++I,D+=4)
-          if((D[3]&0x0F)||M)
-          {
-            DV=S[0]-D[0];
-            if((DV<8)||(DV>248))
-            {
-              DH=S[1]-D[1];
-              if((DH<8)||(DH>248))
-              {
-                PS=SprGen+((int)S[2]<<3);
-                PD=SprGen+((int)D[2]<<3);
-                if(DV<8) PD+=DV; else { DV=256-DV;PS+=DV; }
-                if(DH>248) { DH=256-DH;T=PS;PS=PD;PD=T; }
-                while((DV<8)&&!(*PD&(*PS>>DH))) { DV++;PS++;PD++; }
-                if(DV<8) { VDPStatus[0]|=0x20;return; }
-              }
-            }
-          }
+    AT=SprTab+((int)S[J]<<2);
+    K=(byte)(AT[0]-(ScrMode<4? 0:VScroll));
+    if(K>256-H) K-=256;
+    K=Y-K-1;
+
+    /* Get sprite color and early clock bit */
+    if(ScrMode<4) C=AT[3];
+    else
+    {
+      C=SprTab[-0x0200+((int)S[J]<<4)+K];
+      /* CC and IC sprites do not collide */
+      if(C&0x60) continue;
+    }
+    if(!(C&0x0F)&&!SolidColor0) continue;
+
+    /* Get sprite pattern line, left pixel in bit 31 */
+    PT=SprGen+((int)(H>8? AT[2]&0xFC:AT[2])<<3)+K;
+    M=((unsigned int)PT[0]<<24)|(H>8? (unsigned int)PT[16]<<16:0);
+    if(!M) continue;
+
+    /* Split pattern between two mask words */
+    X=AT[1]+(C&0x80? 0:32);
+    A=M>>(X&31);
+    B=X&31? M<<(32-(X&31)):0;
+    X>>=5;
+    if(!X) A=0;
+    if(X==8) B=0;
+
+    /* Overlapping pixels mean collision */
+    if((Mask[X]&A)|(Mask[X+1]&B)) { VDPStatus[0]|=0x20;return; }
+    Mask[X]|=A;
+    Mask[X+1]|=B;
   }
 }
 
+/** SpriteLine() *********************************************/
+/** Return the list of sprites crossing sprite line Y. The  **/
+/** first byte is the number of sprites, followed by sprite **/
+/** numbers in SprTab order. Lists for all lines are built  **/
+/** in one pass over SprTab and reused until it changes.    **/
+/*************************************************************/
+byte *SpriteLine(register byte Y,byte Stop,byte Offset)
+{
+  register byte *AT,*L;
+  register int H,J,K,N;
+
+  H=Sprites16x16? 16:8;
+
+  /* Rebuild lists if sprites or their layout have changed */
+  if(SprLDirty||(SprLTab!=SprTab)||(SprLStop!=Stop)||(SprLH!=H)||(SprLOff!=Offset))
+  {
+    for(J=0;J<256;J++) SprLines[J][0]=0;
+
+    for(N=0,AT=SprTab;(N<32)&&(AT[0]!=Stop);N++,AT+=4)
+    {
+      K=(byte)(AT[0]-Offset); /* K = sprite Y coordinate      */
+      if(K>256-H) K-=256;     /* Y coordinate may be negative */
+
+      /* Sprite covers lines K+1..K+H */
+      for(J=K<0? 0:K+1;(J<=K+H)&&(J<256);J++)
+      { L=SprLines[J];L[++L[0]]=N; }
+    }
+
+    SprLTab   = SprTab;
+    SprLStop  = Stop;
+    SprLH     = H;
+    SprLOff   = Offset;
+    SprLDirty = 0;
+  }
+
+  return(SprLines[Y]);
+}
+
+/** TouchVRAM() **********************************************/
+/** Notify the emulator that N bytes of VRAM starting at    **/
+/** offset A have been modified.                            **/
+/*************************************************************/
+void TouchVRAM(register int A,register int N)
+{
+  register int S;
+
+  /* Sprite attributes changed: rebuild sprite line lists */
+  S=SprTab-VRAM;
+  if((A<S+128)&&(A+N>S)) SprLDirty=1;
+
+  /* Count writes into each 2kB block, for DirtyLine() */
+  if(N>0)
+    for(S=(A+N-1)>>11,A>>=11;A<=S;A++) VRAMGen[A&63]++;
+}
+
+/** InvalidateScreen() ***************************************/
+/** Force all scanlines to be redrawn on the next frame.    **/
+/*************************************************************/
+void InvalidateScreen(void) { ScreenGen++; }
+
+/** VRAMSig() ************************************************/
+/** Sum write counts of the 2kB VRAM blocks covering N      **/
+/** bytes at offset A, and add these blocks to LineMask[].  **/
+/*************************************************************/
+static unsigned int VRAMSig(register int A,register int N)
+{
+  register unsigned int V;
+  register int J;
+
+  for(V=0,J=(A+N-1)>>11,A>>=11;A<=J;A++)
+  {
+    V+=VRAMGen[A&63];
+    LineMask[(A>>5)&1]|=1<<(A&31);
+  }
+  return(V);
+}
+
+/** DirtyLine() **********************************************/
+/** Compute signature of scanline Y from the VDP registers, **/
+/** palette, and writes into the VRAM this line is drawn    **/
+/** from. Return 0 if the signature matches the one stored  **/
+/** when the line was last drawn, i.e. the image of this    **/
+/** line in the screen buffer is still valid. Signatures    **/
+/** are kept separately for each ScreenPage buffer.         **/
+/*************************************************************/
+int DirtyLine(register byte Y)
+{
+  static const byte Regs[] = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,18,23,25,26,27 };
+  static int LastLine = -1;
+  register unsigned int H,V,*S;
+  register int J,A;
+
+  /* Hash registers and other state the renderers depend on */
+  LineMask[0]=LineMask[1]=0;
+  H=2166136261u^ScreenGen;
+  for(J=0;J<sizeof(Regs);J++) H=(H^VDP[Regs[J]])*16777619u;
+  H=(H^(XFGColor|(XBGColor<<4)|(FontBuf&&(Mode&MSX_FIXEDFONT)? 0x100:0)))*16777619u;
+  H=(H^(ChrTab-VRAM))*16777619u;
+
+  /* Sum writes into the tables this line is drawn from */
+  switch(ScrMode)
+  {
+    case 0:
+      V=VRAMSig(ChrTab-VRAM+40*(Y>>3),40)+VRAMSig(ChrGen-VRAM,0x800);
+      break;
+    case 1:
+    case 3:
+      A=(Y+VScroll)&0xF8;
+      V=VRAMSig(ChrTab-VRAM+(A<<2),32)+VRAMSig(ChrGen-VRAM,0x800)
+       +VRAMSig(ColTab-VRAM,32);
+      break;
+    case 2:
+    case 4:
+      A=(Y+VScroll)&0xF8;
+      V=VRAMSig(ChrTab-VRAM+(A<<2),32)+VRAMSig(ChrGen-VRAM,0x2000)
+       +VRAMSig(ColTab-VRAM,0x2000);
+      break;
+    case 5:
+    case 6:
+      A=ChrTab-VRAM+(((int)(Y+VScroll)<<7)&ChrTabM&0x7FFF);
+      V=VRAMSig(A,256);
+      break;
+    case 7:
+    case 8:
+      A=ChrTab-VRAM+(((int)(Y+VScroll)<<8)&ChrTabM&0xFFFF);
+      V=VRAMSig(A,512);
+      if(HScroll512) V+=VRAMSig(A^0x10000,512);
+      break;
+    case MAXSCREEN+1:
+      V=VRAMSig(ChrTab-VRAM+((80*(Y>>3))&ChrTabM),80)
+       +VRAMSig(ColTab-VRAM+((10*(Y>>3))&ColTabM),10)
+       +VRAMSig(ChrGen-VRAM,0x800);
+      break;
+    default:
+      V=0;
+      break;
+  }
+
+  /* Add sprite tables */
+  if(ScrMode&&(ScrMode<MAXSCREEN+1)&&!SpritesOFF)
+  {
+    V+=VRAMSig(SprGen-VRAM,0x800);
+    A=SprTab-VRAM;
+    V+=ScrMode<4? VRAMSig(A,128):VRAMSig((A-0x200)&0x1FFFF,0x280);
+  }
+
+  /* Line is clean if signatures match, unless the previous */
+  /* line has been redrawn and spilled over into this one    */
+  S=LineSig[ScreenPage&1][Y];
+  if((S[0]==H)&&(S[1]==V))
+    if(!HAdjust||!Y||(LastLine!=Y-1)) return(0);
+
+  S[0]=H;
+  S[1]=V;
+  LastLine=Y;
+  return(1);
+}
+
+/** RenderLine() *********************************************/
+/** Draw scanline Y in the current screen mode.             **/
+/*************************************************************/
+void RenderLine(register byte Y)
+{
+  if(!ModeYJK||(ScrMode<7)||(ScrMode>8))
+    (RefreshLine[ScrMode])(Y);
+  else
+    if(ModeYAE) RefreshLine10(Y);
+    else RefreshLine12(Y);
+}
+
+/** FlushLines() *********************************************/
+/** Draw all scanlines queued by LoopZ80(). Lines are drawn **/
+/** in batches, whenever the VDP state they depend on is    **/
+/** about to change, and at the end of the screen.          **/
+/*************************************************************/
+void FlushLines(void)
+{
+  register int Y;
+
+  if(PendFirst<0) return;
+
+  for(Y=PendFirst;Y<=PendLast;Y++)
+    if(PendLines[Y>>5]&(1<<(Y&31))) RenderLine(Y);
+
+  for(Y=PendFirst>>5;Y<=PendLast>>5;Y++) PendLines[Y]=0;
+  PendMask[0]=PendMask[1]=0;
+  PendFirst=-1;
+}
+
+/** FlushVRAM() **********************************************/
+/** Draw queued scanlines if they show any of N VRAM bytes  **/
+/** at offset A, which are about to be modified.            **/
+/*************************************************************/
+void FlushVRAM(register int A,register int N)
+{
+  register int J;
+
+  if((PendFirst<0)||(N<=0)) return;
+
+  for(J=(A+N-1)>>11,A>>=11;A<=J;A++)
+    if(PendMask[(A>>5)&1]&(1<<(A&31))) { FlushLines();return; }
+}
+
 /** GuessROM() ***********************************************/
 /** Guess MegaROM mapper of a ROM.                          **/
 /*************************************************************/
@@ -2563,7 +2841,7 @@ byte LoadFNT(const char *FileName)
   FILE *F;
 
   /* Drop out if no new font requested */
-  if(!FileName) { FreeMemory(FontBuf);FontBuf=0;return(1); }
+  if(!FileName) { FreeMemory(FontBuf);FontBuf=0;InvalidateScreen();return(1); }
   /* Try opening font file */
   if(!(F=fopen(FileName,"rb"))) return(0);
   /* Allocate memory for 256 8x8 characters, if needed */
@@ -2572,6 +2850,7 @@ byte LoadFNT(const char *FileName)
   if(!FontBuf) { fclose(F);return(0); }
   /* Read font, ignore short reads */
   fread(FontBuf,1,256*8,F);
+  InvalidateScreen();
   /* Done */
   fclose(F);
   return(1);  
@@ -3335,6 +3614,9 @@ int LoadSTA(const char *FileName)
   /* Done with the file */
   fclose(F);
 
+  /* Whole VRAM has changed */
+  TouchVRAM(0,Header[6]*0x4000);
+
   /* Parse hardware state */
   J=0;
   VDPData    = State[J++];
@@ -3395,6 +3677,7 @@ int LoadSTA(const char *FileName)
   /* Set palette */
   for(I=0;I<16;++I)
     SetColor(I,(Palette[I]>>16)&0xFF,(Palette[I]>>8)&0xFF,Palette[I]&0xFF);
+  InvalidateScreen();
 
   /* Set screen mode and VRAM table addresses */
   SetScreen();
@@ -222,6 +222,7 @@ extern byte Verbose;                  /* Debug msgs ON/OFF   */
 extern int  Mode;                     /* ORed MSX_* bits     */
 extern int  RAMPages,VRAMPages;       /* Number of RAM pages */
 extern byte UPeriod;                  /* % of frames to draw */
+extern int  ScreenPage;               /* Screen buffer drawn */
 /*************************************************************/
 
 /** Screen Mode Handlers [number of screens + 1] *************/
@@ -327,6 +328,42 @@ byte ChangeDisk(byte N,const char *FileName);
 /*************************************************************/
 byte LoadFNT(const char *FileName);
 
+/** SpriteLine() *********************************************/
+/** Return the list of sprites crossing sprite line Y. The  **/
+/** first byte is the number of sprites, followed by sprite **/
+/** numbers in SprTab order. Stop is the Y coordinate that  **/
+/** terminates SprTab (208 or 216), Offset is subtracted    **/
+/** from sprite Y coordinates. Lists are built once and     **/
+/** reused until SprTab or the sprite size change.          **/
+/*************************************************************/
+byte *SpriteLine(byte Y,byte Stop,byte Offset);
+
+/** TouchVRAM() **********************************************/
+/** Notify the emulator that N bytes of VRAM starting at    **/
+/** offset A have been modified.                            **/
+/*************************************************************/
+void TouchVRAM(int A,int N);
+
+/** InvalidateScreen() ***************************************/
+/** Force all scanlines to be redrawn on the next frame.    **/
+/** Call this after anything but the emulated VDP changes   **/
+/** the screen buffer or the way it is rendered.            **/
+/*************************************************************/
+void InvalidateScreen(void);
+
+/** FlushLines() *********************************************/
+/** Draw all scanlines queued for rendering. Scanlines are  **/
+/** queued as the beam passes them and drawn in batches     **/
+/** before anything they show changes.                      **/
+/*************************************************************/
+void FlushLines(void);
+
+/** FlushVRAM() **********************************************/
+/** Call this before modifying N bytes of VRAM at offset A, **/
+/** to draw queued scanlines showing these bytes first.     **/
+/*************************************************************/
+void FlushVRAM(int A,int N);
+
 /** InitMachine() ********************************************/
 /** Allocate resources needed by the machine-dependent code.**/
 /************************************ TO BE WRITTEN BY USER **/
@@ -61,6 +61,12 @@
 #define SYSTEM_MSXAUDIO    18
 #define SYSTEM_HIRES       19
 #define SYSTEM_OSI         20
+#define SYSTEM_VOLUME      21 /* + SND_PSG, SND_SCC, ... */
+#define SYSTEM_SYNTHRATE   25
+#define SYSTEM_QUALITY     26
+#define SYSTEM_AUDIOENGINE 27
+#define SYSTEM_SNDBUFFERS  28
+#define SYSTEM_SNDBUFSIZE  29
 
 #define OPTION_DISPLAY_MODE  1
 #define OPTION_FRAME_LIMITER 2
@@ -71,6 +77,7 @@
 #define OPTION_CONTROL_MODE  7
 #define OPTION_ANIMATE       8
 #define OPTION_TOGGLE_VK     9
+#define OPTION_SCREEN_FILTER 10
 
 extern PspImage *Screen;
 
@@ -85,6 +92,7 @@ int Use8950 = 0;
 
 int ShowStatus=0;
 int DisplayMode;
+int ScreenFilter;
 int FrameLimiter;
 int VSync;
 int ClockFreq;
@@ -250,6 +258,12 @@ PL_MENU_OPTIONS_BEGIN(ScreenSizeOptions)
   PL_MENU_OPTION("4:3 scaled (fit height)", DISPLAY_MODE_FIT_HEIGHT)
   PL_MENU_OPTION("16:9 scaled (fit screen)", DISPLAY_MODE_FILL_SCREEN)
 PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(ScreenFilterOptions)
+  PL_MENU_OPTION("Smooth (bilinear)", FILTER_LINEAR)
+  PL_MENU_OPTION("Sharp (nearest)", FILTER_NEAREST)
+  PL_MENU_OPTION("Scanlines", FILTER_SCANLINES)
+  PL_MENU_OPTION("Scale2x", FILTER_SCALE2X)
+PL_MENU_OPTIONS_END
 PL_MENU_OPTIONS_BEGIN(PspClockFreqOptions)
   PL_MENU_OPTION("222 MHz", 222)
   PL_MENU_OPTION("266 MHz", 266)
@@ -260,6 +274,11 @@ PL_MENU_OPTIONS_BEGIN(ControlModeOptions)
   PL_MENU_OPTION("\026\242\020 cancels, \026\241\020 confirms (US)", 0)
   PL_MENU_OPTION("\026\241\020 cancels, \026\242\020 confirms (Japan)", 1)
 PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(FrameLimiterOptions)
+  PL_MENU_OPTION("Disabled", 0)
+  PL_MENU_OPTION("Enabled", 1)
+  PL_MENU_OPTION("Synchronized to audio", 2)
+PL_MENU_OPTIONS_END
 PL_MENU_OPTIONS_BEGIN(FrameSkipOptions)
   PL_MENU_OPTION("No skipping",  0)
   PL_MENU_OPTION("Skip 1 frame", 1)
@@ -277,6 +296,7 @@ PL_MENU_OPTIONS_BEGIN(ButtonMapOptions)
   PL_MENU_OPTION("Special: Previous volume", (SPC|SPC_PDISK))
   PL_MENU_OPTION("Special: Next volume",     (SPC|SPC_NDISK))
   PL_MENU_OPTION("Special: Fast forward",    (SPC|SPC_FF))
+  PL_MENU_OPTION("Special: Start/stop capture", (SPC|SPC_CAPTURE))
     /* Joystick */
   PL_MENU_OPTION("Joystick Up",       (JST|JST_UP))
   PL_MENU_OPTION("Joystick Down",     (JST|JST_DOWN))
@@ -395,6 +415,45 @@ PL_MENU_OPTIONS_END
 PL_MENU_OPTIONS_BEGIN(CartNameOptions)
   PL_MENU_OPTION(EmptySlot, NULL)
 PL_MENU_OPTIONS_END
+#ifdef ALTSOUND
+PL_MENU_OPTIONS_BEGIN(ChipVolumeOptions)
+  PL_MENU_OPTION("Muted",   0)
+  PL_MENU_OPTION("25%",    25)
+  PL_MENU_OPTION("50%",    50)
+  PL_MENU_OPTION("75%",    75)
+  PL_MENU_OPTION("100%",  100)
+  PL_MENU_OPTION("125%",  125)
+  PL_MENU_OPTION("150%",  150)
+  PL_MENU_OPTION("200%",  200)
+PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(SoundQualityOptions)
+  PL_MENU_OPTION("Fast (EMULib)", SND_FAST)
+  PL_MENU_OPTION("Standard", SND_STANDARD)
+  PL_MENU_OPTION("High (native rates)", SND_HIGH)
+PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(AudioEngineOptions)
+  PL_MENU_OPTION("fmopl", SND_FMOPL)
+  PL_MENU_OPTION("emu8950", SND_EMU8950)
+PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(SynthRateOptions)
+  PL_MENU_OPTION("Same as output", 0)
+  PL_MENU_OPTION("32 kHz (faster)", 32000)
+  PL_MENU_OPTION("22 kHz (fastest)", 22050)
+PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(SoundBuffersOptions)
+  PL_MENU_OPTION("2 (lowest latency)", 2)
+  PL_MENU_OPTION("3", 3)
+  PL_MENU_OPTION("4", 4)
+  PL_MENU_OPTION("6", 6)
+  PL_MENU_OPTION("8 (fewest dropouts)", 8)
+PL_MENU_OPTIONS_END
+PL_MENU_OPTIONS_BEGIN(SoundBufSizeOptions)
+  PL_MENU_OPTION("256 samples", 256)
+  PL_MENU_OPTION("512 samples", 512)
+  PL_MENU_OPTION("1024 samples", 1024)
+  PL_MENU_OPTION("2048 samples", 2048)
+PL_MENU_OPTIONS_END
+#endif
 PL_MENU_OPTIONS_BEGIN(VkModeOptions)
   PL_MENU_OPTION("Display when button is held down (classic mode)", 0)
   PL_MENU_OPTION("Toggle display on and off when button is pressed", 1)
@@ -412,12 +471,14 @@ PL_MENU_ITEMS_BEGIN(OptionMenuDef)
   PL_MENU_HEADER("Video")
   PL_MENU_ITEM("Screen size", OPTION_DISPLAY_MODE, ScreenSizeOptions, 
     "\026\250\020 Change screen size")
+  PL_MENU_ITEM("Screen filter", OPTION_SCREEN_FILTER, ScreenFilterOptions,
+    "\026\250\020 Change scaling filter; cost is shown with the FPS counter")
   PL_MENU_HEADER("Input")
   PL_MENU_ITEM("Virtual keyboard mode",OPTION_TOGGLE_VK,VkModeOptions,
                "\026\250\020 Select virtual keyboard mode")
   PL_MENU_HEADER("Performance")
-  PL_MENU_ITEM("Frame limiter", OPTION_FRAME_LIMITER, ToggleOptions,
-    "\026\250\020 Enable/disable correct FPS emulation")
+  PL_MENU_ITEM("Frame limiter", OPTION_FRAME_LIMITER, FrameLimiterOptions,
+    "\026\250\020 Enable/disable correct FPS emulation, optionally paced by sound output")
   PL_MENU_ITEM("Frame skipping", OPTION_FRAMESKIP, FrameSkipOptions,
     "\026\250\020 Change number of frames skipped per update")
   PL_MENU_ITEM("VSync", OPTION_VSYNC, ToggleOptions,
@@ -481,6 +542,24 @@ PL_MENU_ITEMS_BEGIN(SystemMenuDef)
       "\026\250\020 Toggle MSX Music emulation")
   PL_MENU_ITEM("MSX Music emulation", SYSTEM_MSXMUSIC, ToggleOptions,
       "\026\250\020 Toggle MSX Audio emulation")
+  PL_MENU_ITEM("MSX Audio engine", SYSTEM_AUDIOENGINE, AudioEngineOptions,
+      "\026\250\020 Select MSX Audio (Y8950) emulator")
+  PL_MENU_ITEM("Sound quality", SYSTEM_QUALITY, SoundQualityOptions,
+      "\026\250\020 Trade sound accuracy for speed")
+  PL_MENU_ITEM("Synthesis rate", SYSTEM_SYNTHRATE, SynthRateOptions,
+      "\026\250\020 Rate sound chips are emulated at (Standard quality)")
+  PL_MENU_ITEM("Audio buffers", SYSTEM_SNDBUFFERS, SoundBuffersOptions,
+      "\026\250\020 More buffers avoid dropouts, fewer reduce latency")
+  PL_MENU_ITEM("Audio buffer size", SYSTEM_SNDBUFSIZE, SoundBufSizeOptions,
+      "\026\250\020 Larger buffers avoid dropouts, smaller reduce latency")
+  PL_MENU_ITEM("PSG volume", SYSTEM_VOLUME+SND_PSG, ChipVolumeOptions,
+      "\026\250\020 Change PSG volume")
+  PL_MENU_ITEM("SCC volume", SYSTEM_VOLUME+SND_SCC, ChipVolumeOptions,
+      "\026\250\020 Change SCC volume")
+  PL_MENU_ITEM("MSX Music volume", SYSTEM_VOLUME+SND_OPLL, ChipVolumeOptions,
+      "\026\250\020 Change MSX Music volume")
+  PL_MENU_ITEM("MSX Audio volume", SYSTEM_VOLUME+SND_AUDIO, ChipVolumeOptions,
+      "\026\250\020 Change MSX Audio volume")
 #endif
   PL_MENU_HEADER("Video")
   PL_MENU_ITEM("High-resolution renderer", SYSTEM_HIRES, ToggleOptions,
@@ -804,6 +883,9 @@ int OnMenuItemChanged(const struct PspUiMenu *uimenu, pl_menu_item* item,
     case OPTION_DISPLAY_MODE:
       DisplayMode = (int)option->value;
       break;
+    case OPTION_SCREEN_FILTER:
+      ScreenFilter = (int)option->value;
+      break;
     case OPTION_FRAME_LIMITER:
       FrameLimiter = (int)option->value;
       break;
@@ -870,6 +952,71 @@ int OnMenuItemChanged(const struct PspUiMenu *uimenu, pl_menu_item* item,
       }
       break;
 
+#ifdef ALTSOUND
+    case SYSTEM_VOLUME+SND_PSG:
+    case SYSTEM_VOLUME+SND_SCC:
+    case SYSTEM_VOLUME+SND_OPLL:
+    case SYSTEM_VOLUME+SND_AUDIO:
+      /* Picked up by the mixer on its next buffer */
+      SoundGain[item->id - SYSTEM_VOLUME] = (int)option->value;
+      break;
+
+    case SYSTEM_SYNTHRATE:
+      if ((int)option->value != SynthRate)
+      {
+        /* Restart sound engine */
+        TrashAudio();
+        SynthRate = (int)option->value;
+        if (UseSound && !InitSound(UseSound, 0))
+          pspUiAlert("Sound initialization failed");
+      }
+      break;
+
+    case SYSTEM_SNDBUFFERS:
+      if ((int)option->value != SoundBuffers)
+      {
+        /* Restart sound; InitAudio() requeues the buffers */
+        TrashAudio();
+        SoundBuffers = (int)option->value;
+        if (UseSound && !InitSound(UseSound, 0))
+          pspUiAlert("Sound initialization failed");
+      }
+      break;
+
+    case SYSTEM_SNDBUFSIZE:
+      if ((int)option->value != SoundBufSize)
+      {
+        /* Restart sound; InitAudio() requeues the buffers */
+        TrashAudio();
+        SoundBufSize = (int)option->value;
+        if (UseSound && !InitSound(UseSound, 0))
+          pspUiAlert("Sound initialization failed");
+      }
+      break;
+
+    case SYSTEM_AUDIOENGINE:
+      if ((int)option->value != AudioEngine)
+      {
+        /* Restart sound engine; chip registers carry over */
+        TrashAudio();
+        AudioEngine = (int)option->value;
+        if (UseSound && !InitSound(UseSound, 0))
+          pspUiAlert("Sound initialization failed");
+      }
+      break;
+
+    case SYSTEM_QUALITY:
+      if ((int)option->value != SoundQuality)
+      {
+        /* Restart sound engine; chip registers carry over */
+        TrashAudio();
+        SoundQuality = (int)option->value;
+        if (UseSound && !InitSound(UseSound, 0))
+          pspUiAlert("Sound initialization failed");
+      }
+      break;
+#endif
+
     case SYSTEM_CART_A_TYPE:
     case SYSTEM_CART_B_TYPE:
 
@@ -1198,6 +1345,8 @@ static void LoadOptions()
   /* Load values */
   DisplayMode = pl_ini_get_int(&init, "Video", "Display Mode", 
     DISPLAY_MODE_UNSCALED);
+  ScreenFilter = pl_ini_get_int(&init, "Video", "Screen Filter", 
+    FILTER_LINEAR);
   FrameLimiter = pl_ini_get_int(&init, "Video", "Frame Limiter", 1);
   Frameskip = pl_ini_get_int(&init, "Video", "Frameskip", 0);
   VSync = pl_ini_get_int(&init, "Video", "VSync", 0);
@@ -1220,6 +1369,29 @@ static void LoadOptions()
 #ifdef ALTSOUND
   Use2413 = pl_ini_get_int(&init, "Audio", "MSX Music", 0);
   Use8950 = pl_ini_get_int(&init, "Audio", "MSX Audio", 0);
+  AudioEngine = pl_ini_get_int(&init, "Audio", "MSX Audio Engine", SND_FMOPL);
+  SoundQuality = pl_ini_get_int(&init, "Audio", "Sound Quality", SND_STANDARD);
+  SynthRate = pl_ini_get_int(&init, "Audio", "Synthesis Rate", 0);
+  SoundBuffers = pl_ini_get_int(&init, "Audio", "Buffers", 2);
+  SoundBufSize = pl_ini_get_int(&init, "Audio", "Buffer Size", SND_BUFSIZE);
+  SoundGain[SND_PSG] = pl_ini_get_int(&init, "Audio", "PSG Volume", 100);
+  SoundGain[SND_SCC] = pl_ini_get_int(&init, "Audio", "SCC Volume", 100);
+  SoundGain[SND_OPLL] = pl_ini_get_int(&init, "Audio", "MSX Music Volume", 100);
+  SoundGain[SND_AUDIO] = pl_ini_get_int(&init, "Audio", "MSX Audio Volume", 100);
+
+  /* Keep hand-edited values within the menu ranges */
+  if (SoundQuality < SND_FAST || SoundQuality > SND_HIGH)
+    SoundQuality = SND_STANDARD;
+  if (AudioEngine != SND_FMOPL && AudioEngine != SND_EMU8950)
+    AudioEngine = SND_FMOPL;
+  if (SynthRate != 0 && SynthRate != 32000 && SynthRate != 22050)
+    SynthRate = 0;
+  int i;
+  for (i = 0; i < SND_CHIPS; i++)
+  {
+    if (SoundGain[i] < 0) SoundGain[i] = 0;
+    else if (SoundGain[i] > 200) SoundGain[i] = 200;
+  }
 #endif
 
   if (DiskPath) free(DiskPath);
@@ -1250,6 +1422,7 @@ static int SaveOptions()
 
   /* Set values */
   pl_ini_set_int(&init, "Video", "Display Mode", DisplayMode);
+  pl_ini_set_int(&init, "Video", "Screen Filter", ScreenFilter);
   pl_ini_set_int(&init, "Video", "Frame Limiter", FrameLimiter);
   pl_ini_set_int(&init, "Video", "Frameskip", Frameskip);
   pl_ini_set_int(&init, "Video", "VSync", VSync);
@@ -1268,6 +1441,15 @@ static int SaveOptions()
 #ifdef ALTSOUND
   pl_ini_set_int(&init, "Audio", "MSX Audio", Use8950);
   pl_ini_set_int(&init, "Audio", "MSX Music", Use2413);
+  pl_ini_set_int(&init, "Audio", "MSX Audio Engine", AudioEngine);
+  pl_ini_set_int(&init, "Audio", "Sound Quality", SoundQuality);
+  pl_ini_set_int(&init, "Audio", "Synthesis Rate", SynthRate);
+  pl_ini_set_int(&init, "Audio", "Buffers", SoundBuffers);
+  pl_ini_set_int(&init, "Audio", "Buffer Size", SoundBufSize);
+  pl_ini_set_int(&init, "Audio", "PSG Volume", SoundGain[SND_PSG]);
+  pl_ini_set_int(&init, "Audio", "SCC Volume", SoundGain[SND_SCC]);
+  pl_ini_set_int(&init, "Audio", "MSX Music Volume", SoundGain[SND_OPLL]);
+  pl_ini_set_int(&init, "Audio", "MSX Audio Volume", SoundGain[SND_AUDIO]);
 #endif
 
   pl_ini_set_int(&init, "Video", "Hires Renderer", HiresEnabled);
@@ -1297,6 +1479,9 @@ static int SaveOptions()
 void DisplayMenu()
 {
   pl_menu_item *item;
+#ifdef ALTSOUND
+  int i;
+#endif
   ExitMenu = 0;
 
   /* Set normal clock frequency */
@@ -1333,6 +1518,21 @@ void DisplayMenu()
       pl_menu_select_option_by_value(item, (void*)Use8950);
       item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_MSXMUSIC);
       pl_menu_select_option_by_value(item, (void*)Use2413);
+      item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_AUDIOENGINE);
+      pl_menu_select_option_by_value(item, (void*)AudioEngine);
+      item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_QUALITY);
+      pl_menu_select_option_by_value(item, (void*)SoundQuality);
+      item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_SYNTHRATE);
+      pl_menu_select_option_by_value(item, (void*)SynthRate);
+      item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_SNDBUFFERS);
+      pl_menu_select_option_by_value(item, (void*)SoundBuffers);
+      item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_SNDBUFSIZE);
+      pl_menu_select_option_by_value(item, (void*)SoundBufSize);
+      for (i = 0; i < SND_CHIPS; i++)
+      {
+        item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_VOLUME + i);
+        pl_menu_select_option_by_value(item, (void*)SoundGain[i]);
+      }
 #endif
       item = pl_menu_find_item_by_id(&SystemUiMenu.Menu, SYSTEM_OSI);
       pl_menu_select_option_by_value(item, (void*)ShowStatus);
@@ -1358,6 +1558,8 @@ void DisplayMenu()
       /* Init menu options */
       item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_DISPLAY_MODE);
       pl_menu_select_option_by_value(item, (void*)DisplayMode);
+      item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_SCREEN_FILTER);
+      pl_menu_select_option_by_value(item, (void*)ScreenFilter);
       item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_FRAME_LIMITER);
       pl_menu_select_option_by_value(item, (void*)FrameLimiter);
       item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_FRAMESKIP);
@@ -53,11 +53,17 @@
 #define SPC_NDISK 4
 #define SPC_PAUSE 5
 #define SPC_FF    6
+#define SPC_CAPTURE 7
 
 #define DISPLAY_MODE_UNSCALED    0
 #define DISPLAY_MODE_FIT_HEIGHT  1
 #define DISPLAY_MODE_FILL_SCREEN 2
 
+#define FILTER_LINEAR    0
+#define FILTER_NEAREST   1
+#define FILTER_SCANLINES 2
+#define FILTER_SCALE2X   3
+
 #define IS_WIDESCREEN (ScrMode==6||ScrMode==7||ScrMode==13)
 
 struct GameConfig
@@ -24,15 +24,19 @@
 #include "pl_gfx.h"
 #include "pl_perf.h"
 #include "pl_file.h"
+#include "pl_snd.h"
+#include "pl_capture.h"
 #include "MenuPsp.h"
 #include "LibPsp.h"
 
 /** PSP SDK includes *****************************************/
 #include <psprtc.h>
+#include <pspthreadman.h>
 
 /** Standard Unix/X #includes ********************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
@@ -42,19 +46,26 @@ int UseSound  = 44100;          /* Sound driver frequency    */
 extern int FrameLimiter;
 extern int VSync;
 extern int ShowFps;
+extern int ScreenFilter;
 extern int HiresEnabled;
 extern int ShowStatus;
 extern int ToggleVK;
 extern char *ScreenshotPath;
+extern int SoundSuspended;
 
 /** Various variables ****************************************/
 typedef unsigned short pixel;
 
 static unsigned int BPal[256],XPal[80],XPal0; 
+static byte YJKReady;             /* 0: rebuild YJK table from BPal */
+static unsigned int BorderKey[2][HEIGHT]; /* See RefreshBorder() */
 static byte JoyState;
 static int MouseState;
 static int FastForward;
 
+#define TURBO_FRAMES 10 /* Emulated per drawn frame in fast forward */
+#define CAPTURE_FRAMES 8 /* Frames queued for capture before dropping */
+
 /** Sound-related definitions ********************************/
 static int SndSwitch = (1<<MAXCHANNELS)-1;
 static int SndVolume = 255/MAXCHANNELS;
@@ -70,6 +81,11 @@ extern int DisplayMode;
 extern int Frameskip;
 
 PspImage *Screen;
+static PspImage *Screens[2]; /* Drawn alternately, see PutImage() */
+static int GpuBusy;          /* Frame submitted, not yet displayed */
+static PspImage *Scaled;     /* Scale2x output, allocated on use */
+static u32 FilterTicks;      /* CPU time spent by DrawScreen() */
+static u32 FilterGpuTicks;   /* Until GPU finished, if ShowFps */
 static int ScreenX;
 static int ScreenY;
 static int ScreenW;
@@ -80,6 +96,10 @@ static int TicksPerUpdate;
 static u32 TicksPerSecond;
 static u64 LastTick;
 static u64 CurrentTick;
+static int SamplesPerUpdate;  /* Audio samples played per update */
+static unsigned int AudioPos; /* pl_snd_get_position() last frame */
+static int AudioDrift;        /* Samples played minus emulated   */
+static pl_snd_stats AudioStats; /* Last second of audio telemetry */
 static int Frame;
 static int ClearScreen;
 static int LastScrMode=-1;
@@ -87,6 +107,7 @@ static int IconFlashed;
 
 static int PrevDiskHeld;
 static int NextDiskHeld;
+static int CaptureHeld;
 static int ShowKybdHeld;
 static int ShowKybd;
 
@@ -100,6 +121,12 @@ static void OpenMenu();
 static void ResetInput();
 static void HandleSpecialInput(int code, int on);
 static void ResetView();
+static void ShowFrame();
+static void SetTurbo(int on);
+static void ToggleCapture();
+static void DrawScreen();
+static void WaitForTick(u64 T);
+static int SyncToAudio();
 
 static int GetKeyStatus(unsigned int code);
 static inline void HandleKeyboardInput(unsigned int code, int on);
@@ -111,12 +138,18 @@ int InitMachine(void)
 {
   int J,I;
 
-  /* Initialize screen buffer */
-  if (!(Screen = pspImageCreateVram(512, HEIGHT, PSP_IMAGE_16BPP)))
-    return(0);
-  Screen->Viewport.Width = WIDTH;
+  /* Initialize screen buffers */
+  for(J=0;J<2;J++)
+  {
+    if (!(Screens[J] = pspImageCreateVram(512, HEIGHT, PSP_IMAGE_16BPP)))
+      return(0);
+    Screens[J]->Viewport.Width = WIDTH;
+    pspImageClear(Screens[J], 0x8000);
+  }
 
-  pspImageClear(Screen, 0x8000);
+  ScreenPage=0;
+  Screen=Screens[ScreenPage];
+  GpuBusy=0;
 
   /* Initialize keyboard */
   pl_vk_load(&KeyLayout, "system/msx.l2", 
@@ -149,6 +182,7 @@ int InitMachine(void)
     XPal[J+16]=RGB((J&0x30)*255/48,(J&0x0C)*255/12,(J&0x03)*255/3);
     BPal[I]=BPal[I|0x04]=BPal[I|0x20]=BPal[I|0x24]=XPal[J+16];
   }
+  YJKReady=0;
 
   /* Initialize sound */
   if(InitSound(UseSound,150))
@@ -171,10 +205,18 @@ int InitMachine(void)
 /*************************************************************/
 void TrashMachine(void)
 {
+  pl_capture_stop();
   TrashSound();
 
-  /* Destroy screen buffer */
-  if (Screen) pspImageDestroy(Screen);
+  /* Let the GPU finish with the screen buffers */
+  ShowFrame();
+
+  /* Destroy screen buffers */
+  if (Screens[0]) pspImageDestroy(Screens[0]);
+  if (Screens[1]) pspImageDestroy(Screens[1]);
+  Screen = Screens[0] = Screens[1] = NULL;
+  if (Scaled) pspImageDestroy(Scaled);
+  Scaled = NULL;
 
   /* Destroy keyboard */
   pl_vk_destroy(&KeyLayout);
@@ -183,6 +225,26 @@ void TrashMachine(void)
   TrashMenu();
 }
 
+/** AppendText() *********************************************/
+/** Append printf()-formatted text at Buf+Len, truncating   **/
+/** it to fit Size bytes. Returns the new length, which     **/
+/** stays at Size-1 once the buffer is full.                **/
+/*************************************************************/
+static int AppendText(char *Buf, int Size, int Len, const char *Fmt, ...)
+{
+  va_list Args;
+  int N;
+
+  if (Len >= Size - 1) return Size - 1;
+
+  va_start(Args, Fmt);
+  N = vsnprintf(Buf + Len, Size - Len, Fmt, Args);
+  va_end(Args);
+
+  if (N < 0) { Buf[Len] = '\0'; return Len; }
+  return (Len + N < Size) ? Len + N : Size - 1;
+}
+
 /** PutImage() ***********************************************/
 /** Put an image on the screen.                             **/
 /*************************************************************/
@@ -192,6 +254,9 @@ void PutImage(void)
   if (++Frame <= Frameskip) return;
   Frame = 0;
 
+  /* Display previous frame, once the GPU is done with it */
+  ShowFrame();
+
   pspVideoBegin();
 
   /* Clear the buffer first, if necessary */
@@ -205,7 +270,10 @@ void PutImage(void)
   if (LastScrMode!=ScrMode) ResetView();
 
   /* Draw the screen */
-  pl_gfx_put_image(Screen, ScreenX, ScreenY, ScreenW, ScreenH);
+  DrawScreen();
+
+  /* Queue the frame for capture, if recording */
+  if (pl_capture_is_active()) pl_capture_put_frame(Screen);
 
   /* Draw keyboard */
   if (ShowKybd)
@@ -230,14 +298,65 @@ void PutImage(void)
   {
     float fps = pl_perf_update_counter(&FpsCounter);
 
-    static char fps_display[16];
-    sprintf(fps_display, " %3.02f ", fps);
+    static char fps_display[64];
+    int len;
+
+    /* Screen filter cost (CPU/GPU), then audio drift (samples) */
+    /* and underruns                                             */
+    len = AppendText(fps_display, sizeof(fps_display), 0,
+      " %3.02f %.2f/%.2fms ", fps,
+      (float)FilterTicks * 1000.0f / (float)TicksPerSecond,
+      (float)FilterGpuTicks * 1000.0f / (float)TicksPerSecond);
+    if (FrameLimiter == 2)
+      len = AppendText(fps_display, sizeof(fps_display), len, "%+d/%u ",
+        AudioDrift, pl_snd_get_underruns(0));
+
+    /* Audio buffering, then mean and worst time the sound */
+    /* callback took over the last second of output        */
+    pl_snd_stats stats;
+    if (pl_snd_get_stats(0, &stats)
+      && stats.callbacks * stats.samples >= 44100)
+    {
+      AudioStats = stats;
+      pl_snd_reset_stats(0);
+    }
+    if (AudioStats.callbacks)
+      len = AppendText(fps_display, sizeof(fps_display), len,
+        "%ux%u %.1f/%.1fms ",
+        AudioStats.buffers, AudioStats.samples,
+        (float)AudioStats.callback_us / AudioStats.callbacks / 1000.0f,
+        (float)AudioStats.callback_max_us / 1000.0f);
 
     int width = pspFontGetTextWidth(&PspStockFont, fps_display);
     int height = pspFontGetLineHeight(&PspStockFont);
 
     pspVideoFillRect(SCR_WIDTH - width, 0, SCR_WIDTH, height, PSP_COLOR_BLACK);
     pspVideoPrint(&PspStockFont, SCR_WIDTH - width, 0, fps_display, PSP_COLOR_WHITE);
+
+#ifdef ALTSOUND
+    /* Sound quality and audio thread load, then chip render */
+    /* speed, thousands of samples/second                    */
+    static const char *QualityNames[] = { "Fast", "Std", "High" };
+    static const char *ChipNames[SND_CHIPS] = { "PSG", "SCC", "FM", "AUD" };
+    unsigned int load = GetSoundLoad();
+    int chip;
+
+    len = load ? AppendText(fps_display, sizeof(fps_display), 0, " %s %u.%u%%",
+      QualityNames[SoundQuality], load / 10, load % 10) : 0;
+    for (chip = 0; chip < SND_CHIPS; chip++)
+      if (GetChipRate(chip))
+        len = AppendText(fps_display, sizeof(fps_display), len, " %s %uk",
+          ChipNames[chip], GetChipRate(chip) / 1000);
+
+    if (len)
+    {
+      AppendText(fps_display, sizeof(fps_display), len, " ");
+      width = pspFontGetTextWidth(&PspStockFont, fps_display);
+
+      pspVideoFillRect(SCR_WIDTH - width, height, SCR_WIDTH, height * 2, PSP_COLOR_BLACK);
+      pspVideoPrint(&PspStockFont, SCR_WIDTH - width, height, fps_display, PSP_COLOR_WHITE);
+    }
+#endif
   }
 
   /* Status indicators */
@@ -252,16 +371,89 @@ void PutImage(void)
     else if (IconFlashed) ClearScreen = 1;
   }
 
-  pspVideoEnd();
+  /* Let the GPU draw this frame while the next one is emulated */
+  pspVideoEndAsync();
+  GpuBusy = 1;
+
+  /* Next frame is rendered into the other screen buffer */
+  ScreenPage ^= 1;
+  Screen = Screens[ScreenPage];
+}
+
+/** DrawScreen() ********************************************/
+/** Draw the emulated screen with the selected filter, and  **/
+/** measure how long it takes. While FPS are shown, the GPU **/
+/** is synced before and after, to time its side as well.   **/
+/*************************************************************/
+static void DrawScreen()
+{
+  u64 Start, End;
+
+  /* Start with the GPU idle, so it only works on the filter */
+  if (ShowFps) { pspVideoEnd();pspVideoBegin(); }
+  sceRtcGetCurrentTick(&Start);
+
+  pl_gfx_set_filter((ScreenFilter == FILTER_NEAREST)
+    ? PL_GFX_FILTER_NEAREST : PL_GFX_FILTER_LINEAR);
+  pl_gfx_put_image(Screen, ScreenX, ScreenY, ScreenW, ScreenH);
+
+  /* Scale2x the 256-pixel active area of low resolution modes, */
+  /* and draw it over the border, where Common.h put it         */
+  if (ScreenFilter == FILTER_SCALE2X && Screen->Viewport.Width == WIDTH
+    && (Scaled || (Scaled = pspImageCreate(512, 2 * HEIGHT, PSP_IMAGE_16BPP))))
+  {
+    PspViewport Viewport = Screen->Viewport;
+    int X = (WIDTH - 256) / 2 + HAdjust;
+    Screen->Viewport.X = Viewport.X + X;
+    Screen->Viewport.Width = 256;
+
+    if (pl_gfx_scale2x(Screen, Scaled))
+      pl_gfx_put_image(Scaled, ScreenX + ScreenW * X / WIDTH,
+        ScreenY, ScreenW * 256 / WIDTH, ScreenH);
+
+    Screen->Viewport = Viewport;
+  }
+
+  /* Darken every other line in a second pass */
+  if (ScreenFilter == FILTER_SCANLINES)
+    pl_gfx_put_scanlines(ScreenX, ScreenY, ScreenW, ScreenH, 0x60);
+
+  sceRtcGetCurrentTick(&End);
+  FilterTicks = (u32)(End - Start);
+
+  /* Wait for the GPU to finish, and reopen the list */
+  if (ShowFps)
+  {
+    pspVideoEnd();
+    sceRtcGetCurrentTick(&End);
+    FilterGpuTicks = (u32)(End - Start);
+    pspVideoBegin();
+  }
+}
+
+/** ShowFrame() **********************************************/
+/** Wait for the GPU to finish the frame submitted by the   **/
+/** last PutImage() call, pace and display it.              **/
+/*************************************************************/
+static void ShowFrame()
+{
+  if (!GpuBusy) return;
+  GpuBusy = 0;
+
+  pspVideoSync();
 
   if (!FastForward)
   {
     /* Wait if needed */
     if (FrameLimiter)
     {
-      do { sceRtcGetCurrentTick(&CurrentTick); }
-      while (CurrentTick - LastTick < TicksPerUpdate);
-      LastTick = CurrentTick;
+      /* Frame limiter 2 follows the audio clock */
+      LastTick += TicksPerUpdate - ((FrameLimiter == 2) ? SyncToAudio() : 0);
+      WaitForTick(LastTick);
+
+      /* Don't try to catch up if we're more than a frame late */
+      if (CurrentTick - LastTick > TicksPerUpdate)
+        LastTick = CurrentTick;
     }
 
     /* Wait for VSync signal */
@@ -272,6 +464,84 @@ void PutImage(void)
   pspVideoSwapBuffers();
 }
 
+/** SetTurbo() ***********************************************/
+/** Enter or leave fast forward. While on, frames are not   **/
+/** paced, only one in TURBO_FRAMES is rendered, and sound  **/
+/** chips receive register writes but produce no samples.   **/
+/*************************************************************/
+static void SetTurbo(int on)
+{
+  FastForward = on;
+  UPeriod = on ? 100 / TURBO_FRAMES : 100;
+  SoundSuspended = on;
+}
+
+/** ToggleCapture() *****************************************/
+/** Start or stop recording presented frames as a PNG      **/
+/** sequence, and sound as a WAV file, in the background.  **/
+/*************************************************************/
+static void ToggleCapture()
+{
+  if (pl_capture_is_active())
+  {
+    unsigned int Dropped = pl_capture_get_frames_dropped();
+    pl_capture_stop();
+    sprintf(Message, "Capture stopped, %u frames dropped", Dropped);
+  }
+  else if (pl_capture_start(ScreenshotPath, "capture", 512, HEIGHT,
+    CAPTURE_FRAMES, UseSound))
+    sprintf(Message, "Capture started");
+  else
+    sprintf(Message, "\022Error starting capture");
+
+  MessageTimer = 60 * 3;
+}
+
+/** WaitForTick() ********************************************/
+/** Sleep until shortly before tick T, then spin until T,   **/
+/** so waiting does not hold the CPU for the whole frame.   **/
+/*************************************************************/
+static void WaitForTick(u64 T)
+{
+  sceRtcGetCurrentTick(&CurrentTick);
+
+  /* Leave ~1ms to absorb thread wakeup latency */
+  if (T > CurrentTick + TicksPerSecond / 1000)
+    sceKernelDelayThread((u32)((T - CurrentTick - TicksPerSecond / 1000)
+      * 1000000 / TicksPerSecond));
+
+  do { sceRtcGetCurrentTick(&CurrentTick); }
+  while (CurrentTick < T);
+}
+
+/** SyncToAudio() ********************************************/
+/** Track how far audio playback has drifted from emulated  **/
+/** time and return the number of ticks to take off the     **/
+/** next frame (negative to lengthen it), at most 0.5% of   **/
+/** a frame.                                                **/
+/*************************************************************/
+static int SyncToAudio()
+{
+  unsigned int Pos = pl_snd_get_position(0);
+  int Played = Pos - AudioPos, Ticks, Limit;
+  AudioPos = Pos;
+
+  /* Sound disabled or not rendering: nothing to follow */
+  if (!SamplesPerUpdate || SoundSuspended) return 0;
+
+  AudioDrift += Played - SamplesPerUpdate;
+
+  /* Resync after stalls (disk access, etc) instead of racing */
+  if (AudioDrift > 8 * SamplesPerUpdate || AudioDrift < -8 * SamplesPerUpdate)
+    AudioDrift = 0;
+
+  /* One frame of drift gives the maximum correction */
+  Limit = TicksPerUpdate / 200;
+  Ticks = (int)((long long)Limit * AudioDrift / SamplesPerUpdate);
+
+  return (Ticks > Limit) ? Limit : (Ticks < -Limit) ? -Limit : Ticks;
+}
+
 /** GetKeyboardStatus() **************************************/
 /** Gets status of specific MSX key (set/unset).            **/
 /*************************************************************/
@@ -389,15 +659,26 @@ static void ResetInput()
 /*************************************************************/
 static void OpenMenu()
 {
-  /* Stop sound & display menu */
+  /* Finish the frame in progress on GPU */
+  ShowFrame();
+
+  /* Stop sound & display menu, showing the last complete frame */
   StopSound();
+  Screen = Screens[ScreenPage^1];
   DisplayMenu();
+  Screen = Screens[ScreenPage];
 
-  /* Reset view */
+  /* Reset view, redraw the entire screen */
   ResetView();
+  InvalidateScreen();
+  memset(BorderKey, 0, sizeof(BorderKey));
 
   /* Reset FPS counter */
   pl_perf_init_counter(&FpsCounter);
+#ifdef ALTSOUND
+  /* Measure sound chips while FPS are displayed */
+  SoundStats = ShowFps;
+#endif
 
   /* Recompute update frequency */
   TicksPerSecond = sceRtcGetTickResolution();
@@ -405,10 +686,13 @@ static void OpenMenu()
   {
     int UpdateFreq = (Mode & MSX_VIDEO) == MSX_NTSC ? 60 : 50;
     TicksPerUpdate = TicksPerSecond / (UpdateFreq / (Frameskip + 1));
+    SamplesPerUpdate = UseSound * (Frameskip + 1) / UpdateFreq;
     sceRtcGetCurrentTick(&LastTick);
+    AudioPos = pl_snd_get_position(0);
+    AudioDrift = 0;
   }
 
-  FastForward = 0;
+  SetTurbo(0);
   Frame = 0;
   ShowKybdHeld = 0;
   ShowKybd = 0;
@@ -528,7 +812,15 @@ static void HandleSpecialInput(int code, int on)
 
   case SPC_FF:
 
-    FastForward = on;
+    SetTurbo(on);
+    break;
+
+  case SPC_CAPTURE:
+
+    if (CaptureHeld != on && on)
+      ToggleCapture();
+
+    CaptureHeld = on;
     break;
   }
 }
@@ -567,6 +859,9 @@ void ResetView()
   ScreenX=(SCR_WIDTH / 2)-(ScreenW / 2);
   ScreenY=(SCR_HEIGHT / 2)-(ScreenH / 2);
 
+  /* Both screen buffers share the viewport */
+  Screens[ScreenPage^1]->Viewport = Screen->Viewport;
+
   LastScrMode=ScrMode;
   ClearScreen=1;
 }
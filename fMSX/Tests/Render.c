@@ -0,0 +1,110 @@
+/** fMSX: portable MSX emulator ******************************/
+/**                                                         **/
+/**                         Render.c                        **/
+/**                                                         **/
+/** This file builds the screen drivers from Common.h on    **/
+/** the host, for RenderTest.c. It is compiled twice, with  **/
+/** and without NO_WIDE_RENDER, and RENDER() gives each     **/
+/** copy its own entry points.                              **/
+/*************************************************************/
+
+#ifdef NO_WIDE_RENDER
+#define RENDER(Name) Ref##Name
+#else
+#define RENDER(Name) Wide##Name
+#endif
+
+/** Drivers with external linkage get a per-copy name ********/
+#define RefreshScreen   RENDER(RefreshScreen)
+#define RefreshLineF    RENDER(RefreshLineF)
+#define RefreshLine0    RENDER(RefreshLine0)
+#define RefreshLine1    RENDER(RefreshLine1)
+#define RefreshLine2    RENDER(RefreshLine2)
+#define RefreshLine3    RENDER(RefreshLine3)
+#define RefreshLine4    RENDER(RefreshLine4)
+#define RefreshLine5    RENDER(RefreshLine5)
+#define RefreshLine6    RENDER(RefreshLine6)
+#define RefreshLine7    RENDER(RefreshLine7)
+#define RefreshLine8    RENDER(RefreshLine8)
+#define RefreshLine10   RENDER(RefreshLine10)
+#define RefreshLine12   RENDER(RefreshLine12)
+#define RefreshLineTx80 RENDER(RefreshLineTx80)
+#define PutImage        RENDER(PutImage)
+
+#include "MSX.h"
+#include "MenuPsp.h"
+#include "RenderTest.h"
+
+#include <string.h>
+
+/** Machine driver state, as in Psp.c ************************/
+typedef unsigned short pixel;
+
+static unsigned int BPal[256],XPal[80],XPal0;
+static byte YJKReady;
+static unsigned int BorderKey[2][HEIGHT];
+extern int HiresEnabled;
+
+typedef struct { int Width;void *Pixels; } RTImage;
+static RTImage Image;
+static RTImage *Screen = &Image;
+
+void PutImage(void) { }
+
+#include "Common.h"
+
+/** RENDER(Frame)() ******************************************/
+/** Render a frame of the current screen mode into Buf, a   **/
+/** 512 pixel wide page of HEIGHT rows, using palette Pal.  **/
+/** Border cache and YJK table persist between frames, as   **/
+/** they do on the PSP, unless Pal changes.                 **/
+/*************************************************************/
+void RENDER(Frame)(pixel *Buf,const RTPalette *Pal)
+{
+  register int Y,N;
+
+  if(memcmp(XPal+1,Pal->XPal+1,sizeof(XPal)-sizeof(XPal[0]))
+   ||memcmp(BPal,Pal->BPal,sizeof(BPal))||(XPal0!=Pal->XPal0))
+  {
+    memcpy(XPal,Pal->XPal,sizeof(XPal));
+    memcpy(BPal,Pal->BPal,sizeof(BPal));
+    XPal0=Pal->XPal0;
+    YJKReady=0;
+  }
+
+  Image.Width=512;
+  Image.Pixels=Buf;
+
+  /* Scanlines are drawn the way RenderLine() does it */
+  N=ScanLines212? 212:192;
+  for(Y=0;Y<N;Y++)
+    if(!ModeYJK||(ScrMode<7)||(ScrMode>8))
+      switch(ScrMode)
+      {
+        case 0:  RefreshLine0(Y);break;
+        case 1:  RefreshLine1(Y);break;
+        case 2:  RefreshLine2(Y);break;
+        case 3:  RefreshLine3(Y);break;
+        case 4:  RefreshLine4(Y);break;
+        case 5:  RefreshLine5(Y);break;
+        case 6:  RefreshLine6(Y);break;
+        case 7:  RefreshLine7(Y);break;
+        case 8:  RefreshLine8(Y);break;
+        case 10:
+        case 11: RefreshLine10(Y);break;
+        case 12: RefreshLine12(Y);break;
+        default: RefreshLineTx80(Y);break;
+      }
+    else
+      if(ModeYAE) RefreshLine10(Y);
+      else RefreshLine12(Y);
+}
+
+/** RENDER(ClearBorders)() ***********************************/
+/** Forget what borders were painted, as Psp.c does when    **/
+/** the screen buffers are overwritten.                     **/
+/*************************************************************/
+void RENDER(ClearBorders)(void)
+{
+  memset(BorderKey,0,sizeof(BorderKey));
+}
@@ -0,0 +1,262 @@
+/** fMSX: portable MSX emulator ******************************/
+/**                                                         **/
+/**                       RenderTest.c                      **/
+/**                                                         **/
+/** This file contains a host program that renders random   **/
+/** VRAM and VDP register states through both builds of the **/
+/** screen drivers in Common.h, word-wide and per-pixel,    **/
+/** and checks that they produce the same pixels. Run it    **/
+/** with "make" in this directory after changing Common.h.  **/
+/*************************************************************/
+
+#include "MSX.h"
+#include "MenuPsp.h"
+#include "RenderTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define VRAM_SIZE 0x20000   /* 128kB, as with 8 VRAM pages   */
+#define VRAM_ALLOC 0x80000  /* Room to align and overrun     */
+#define PAGE_SIZE (512*HEIGHT)
+#define GUARD     512       /* Pixels kept clear around pages */
+
+/** Emulation state used by the screen drivers ***************/
+byte Verbose   = 0;
+int  Mode      = 0;
+int  ScreenPage = 0;
+int  HiresEnabled = 0;
+byte *VRAM;
+byte VDP[64];
+byte *ChrGen,*ChrTab,*ColTab;
+byte *SprGen,*SprTab;
+int  ChrGenM,ChrTabM,ColTabM;
+byte FGColor,BGColor;
+byte XFGColor,XBGColor;
+byte ScrMode;
+byte *FontBuf;
+
+static byte Font[256*8];
+static unsigned short WideBuf[2][GUARD+PAGE_SIZE+GUARD];
+static unsigned short RefBuf[2][GUARD+PAGE_SIZE+GUARD];
+static RTPalette Pal;
+static int PtrFitsInt;      /* 1: (int)VRAM pointer is valid */
+static unsigned int Seed = 2008;
+
+/** Rnd() ****************************************************/
+/** Return next value of a 32bit xorshift generator.        **/
+/*************************************************************/
+static unsigned int Rnd(void)
+{
+  Seed^=Seed<<13;
+  Seed^=Seed>>17;
+  Seed^=Seed<<5;
+  return(Seed);
+}
+
+/** SpriteLine() *********************************************/
+/** Same result as SpriteLine() in MSX.c: entry 0 is the    **/
+/** number of sprites covering line Y, followed by their    **/
+/** numbers. Not cached, as sprites change every frame.     **/
+/*************************************************************/
+byte *SpriteLine(register byte Y,byte Stop,byte Offset)
+{
+  static byte L[33];
+  register byte *AT;
+  register int H,K,N;
+
+  H=Sprites16x16? 16:8;
+  L[0]=0;
+
+  for(N=0,AT=SprTab;(N<32)&&(AT[0]!=Stop);N++,AT+=4)
+  {
+    K=(byte)(AT[0]-Offset); /* K = sprite Y coordinate      */
+    if(K>256-H) K-=256;     /* Y coordinate may be negative */
+    if((Y>K)&&(Y<=K+H)) L[++L[0]]=N;
+  }
+
+  return(L);
+}
+
+/** AllocVRAM() **********************************************/
+/** Get VRAM aligned to 256kB, so that SCREEN12 HScroll512  **/
+/** flipping bit 16 stays inside it. On Linux, map it below **/
+/** 2GB, as RefreshLine12() passes pointers through int.    **/
+/*************************************************************/
+static byte *AllocVRAM(void)
+{
+  byte *P=0;
+
+#if defined(__linux__) && defined(MAP_32BIT)
+  P=(byte *)mmap(0,VRAM_ALLOC,PROT_READ|PROT_WRITE,
+    MAP_PRIVATE|MAP_ANONYMOUS|MAP_32BIT,-1,0);
+  if(P==(byte *)MAP_FAILED) P=0;
+#endif
+  if(!P&&!(P=(byte *)malloc(VRAM_ALLOC))) return(0);
+
+  P=(byte *)(((unsigned long)P+0x3FFFF)&~0x3FFFFUL);
+  PtrFitsInt=(byte *)(long)(int)(long)P==P;
+  return(P);
+}
+
+/** Table() **************************************************/
+/** Return a random VDP table address. Most are aligned, as **/
+/** on the MSX, the rest exercise unaligned VRAM reads.     **/
+/*************************************************************/
+static byte *Table(int Min)
+{
+  register int A;
+
+  A=Min+Rnd()%(VRAM_SIZE-Min);
+  return(VRAM+(Rnd()&3? A&~0x3FF:A));
+}
+
+/** RandomPalette() ******************************************/
+/** Fill Pal with distinct-looking random 16bit colors.     **/
+/*************************************************************/
+static void RandomPalette(void)
+{
+  register int J;
+
+  for(J=0;J<80;J++)  Pal.XPal[J]=Rnd()&0xFFFF;
+  for(J=0;J<256;J++) Pal.BPal[J]=Rnd()&0xFFFF;
+  Pal.XPal0=Rnd()&0xFFFF;
+}
+
+/** RandomState() ********************************************/
+/** Pick a screen mode, VDP registers, tables, VRAM, and    **/
+/** sprites at random.                                      **/
+/*************************************************************/
+static void RandomState(void)
+{
+  static const byte Modes[] = { 0,1,2,3,4,5,6,7,8,10,11,12,MAXSCREEN+1 };
+  register byte *AT;
+  register int J,N;
+
+  for(J=0;J<VRAM_SIZE;J+=4) *(unsigned int *)(VRAM+J)=Rnd();
+  for(J=0;J<64;J++) VDP[J]=Rnd();
+
+  ScrMode=Modes[Rnd()%sizeof(Modes)];
+
+  /* Screen mostly on, sprites mostly on */
+  if(Rnd()&7)  VDP[1]|=0x40;
+  if(Rnd()&3)  VDP[8]&=~0x02;
+  if(!PtrFitsInt) VDP[25]&=~0x01;
+
+  FGColor  = VDP[7]>>4;
+  BGColor  = VDP[7]&0x0F;
+  XFGColor = Rnd()&0x0F;
+  XBGColor = Rnd()&0x0F;
+  Mode     = Rnd()&(MSX_ALLSPRITE|MSX_FIXEDFONT);
+  FontBuf  = Rnd()&1? Font:0;
+  HiresEnabled = Rnd()&1;
+
+  ChrTab  = Table(0);
+  ChrGen  = Table(0);
+  ColTab  = Table(0);
+  SprGen  = Table(0);
+  SprTab  = Table(0x400);   /* Sprite colors are at -0x200 */
+  ChrTabM = Rnd()&1? -1:(int)(Rnd()|0x3FF);
+  ChrGenM = Rnd()&1? -1:(int)(Rnd()|0x3FF);
+  ColTabM = Rnd()&1? -1:(int)(Rnd()|0x3FF);
+
+  /* Up to 32 sprites, spread over the visible lines */
+  N=Rnd()%33;
+  for(J=0,AT=SprTab;J<32;J++,AT+=4)
+  {
+    AT[0]=J<N? Rnd()%224:(ScrMode<4? 208:216);
+    AT[1]=Rnd();
+    AT[2]=Rnd();
+    AT[3]=Rnd();
+  }
+}
+
+/** Overrun() ************************************************/
+/** Return 1 if a driver wrote into the GUARD pixels before **/
+/** or after page Buf.                                      **/
+/*************************************************************/
+static int Overrun(unsigned short *Buf)
+{
+  register int J;
+
+  for(J=0;J<GUARD;J++)
+    if(Buf[J]||Buf[GUARD+PAGE_SIZE+J]) return(1);
+  return(0);
+}
+
+/** CompareFrame() *******************************************/
+/** Compare both renderings of page ScreenPage line by line **/
+/** and report the first difference. Returns 1 if the same. **/
+/*************************************************************/
+static int CompareFrame(int Frame)
+{
+  register unsigned short *W,*R;
+  register int Y,X;
+
+  if(Overrun(WideBuf[ScreenPage])||Overrun(RefBuf[ScreenPage]))
+  {
+    fprintf(stderr,"Frame %d: SCREEN %d wrote outside the page\n",
+      Frame,ScrMode);
+    return(0);
+  }
+
+  W=WideBuf[ScreenPage]+GUARD;
+  R=RefBuf[ScreenPage]+GUARD;
+
+  for(Y=0;Y<HEIGHT;Y++,W+=512,R+=512)
+    if(memcmp(W,R,512*sizeof(*W)))
+    {
+      for(X=0;W[X]==R[X];X++);
+      fprintf(stderr,
+        "Frame %d: SCREEN %d differs at row %d, pixel %d: %04X, not %04X\n"
+        "  VDP[1]=%02X VDP[8]=%02X VDP[9]=%02X VDP[18]=%02X VDP[23]=%02X"
+        " VDP[25]=%02X HiRes=%d ChrTab=%05X\n",
+        Frame,ScrMode,Y,X,W[X],R[X],
+        VDP[1],VDP[8],VDP[9],VDP[18],VDP[23],VDP[25],
+        HiresEnabled,(int)(ChrTab-VRAM));
+      return(0);
+    }
+
+  return(1);
+}
+
+int main(int argc,char *argv[])
+{
+  register int J,Frames;
+
+  Frames=argc>1? atoi(argv[1]):5000;
+  if(argc>2) Seed=(unsigned int)strtoul(argv[2],0,0);
+
+  if(!(VRAM=AllocVRAM()))
+  {
+    fprintf(stderr,"Can't allocate VRAM\n");
+    return(1);
+  }
+
+  for(J=0;J<sizeof(Font);J++) Font[J]=Rnd();
+  memset(WideBuf,0,sizeof(WideBuf));
+  memset(RefBuf,0,sizeof(RefBuf));
+
+  for(J=0;J<Frames;J++)
+  {
+    /* Palette changes now and then, so that the YJK table */
+    /* and the border cache are reused between frames      */
+    if(!(J&15)) RandomPalette();
+    if(!(Rnd()&15)) { WideClearBorders();RefClearBorders(); }
+
+    RandomState();
+    WideFrame(WideBuf[ScreenPage]+GUARD,&Pal);
+    RefFrame(RefBuf[ScreenPage]+GUARD,&Pal);
+    if(!CompareFrame(J)) return(1);
+
+    ScreenPage^=1;
+  }
+
+  printf("%d frames identical%s\n",Frames,
+    PtrFitsInt? "":" (SCREEN12 HScroll512 not tested)");
+  return(0);
+}
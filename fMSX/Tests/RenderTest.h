@@ -0,0 +1,30 @@
+/** fMSX: portable MSX emulator ******************************/
+/**                                                         **/
+/**                       RenderTest.h                      **/
+/**                                                         **/
+/** This file declares the two builds of the screen drivers **/
+/** compared by RenderTest.c. See Render.c.                 **/
+/*************************************************************/
+#ifndef RENDERTEST_H
+#define RENDERTEST_H
+
+/** RTPalette ************************************************/
+/** Colors the machine driver keeps in XPal[], XPal0, and   **/
+/** BPal[], as 16bit pixels.                                **/
+/*************************************************************/
+typedef struct
+{
+  unsigned int XPal[80];
+  unsigned int XPal0;
+  unsigned int BPal[256];
+} RTPalette;
+
+/** Word-wide drivers, NO_WIDE_RENDER undefined **************/
+void WideFrame(unsigned short *Buf,const RTPalette *Pal);
+void WideClearBorders(void);
+
+/** Reference per-pixel drivers, NO_WIDE_RENDER defined ******/
+void RefFrame(unsigned short *Buf,const RTPalette *Pal);
+void RefClearBorders(void);
+
+#endif /* RENDERTEST_H */
@@ -166,6 +166,7 @@ static int  PPB[4]  = { 2,4,2,1 };
 static int  PPL[4]  = { 256,512,512,256 };
 static int  VdpOpsCnt=1;
 static void (*VdpEngine)(void)=0;
+static int  DstA,DstN;     /* VRAM area written by the command */
 
                       /*  SprOn SprOn SprOf SprOf */
                       /*  ScrOf ScrOn ScrOf ScrOn */
@@ -853,7 +854,7 @@ void VDPWrite(byte V)
 {
   VDPStatus[2]&=0x7F;
   VDPStatus[7]=VDP[44]=V;
-  if(VdpEngine&&(VdpOpsCnt>0)) VdpEngine();
+  if(VdpEngine&&(VdpOpsCnt>0)) { FlushVRAM(DstA,DstN);VdpEngine();TouchVRAM(DstA,DstN); }
 }
 
 /** VDPRead() ************************************************/
@@ -939,11 +940,15 @@ byte VDPDraw(byte Op)
     case CM_PSET:
       VDPStatus[2]&=0xFE;
       VdpEngine=0;  
+      FlushVRAM(VDP_VRMP(SM,VDP[36]+((int)VDP[37]<<8),
+                            VDP[38]+((int)VDP[39]<<8))-VRAM,1);
       VDP_PSET(SM, 
                VDP[36]+((int)VDP[37]<<8),
                VDP[38]+((int)VDP[39]<<8),
                VDP[44],
                Op&0x0F);
+      TouchVRAM(VDP_VRMP(SM,VDP[36]+((int)VDP[37]<<8),
+                            VDP[38]+((int)VDP[39]<<8))-VRAM,1);
       return 1;
     case CM_SRCH:
       VdpEngine=SrchEngine;
@@ -1017,11 +1022,30 @@ byte VDPDraw(byte Op)
   else
     MMC.ANX = MMC.NX;
 
+  /* Find VRAM rows the command may write to */
+  if((MMC.CM==CM_SRCH)||(MMC.CM==CM_LMCM)) DstA=DstN=0;
+  else
+  {
+    register int Y0,Y1,L,N;
+
+    /* LINE may run along Y for NX dots */
+    N  = MMC.NY? MMC.NY:1024;
+    if((MMC.CM==CM_LINE)&&(MMC.NX>=N)) N=MMC.NX+1;
+    L  = SM<2? 7:8;
+    Y0 = Y1 = MMC.DY;
+    if(MMC.TY>0) Y1+=N-1; else Y0-=N-1;
+    /* Rows above 0 wrap to the end of VRAM, so cover all rows */
+    if(Y0<0) { Y0=0;Y1=1023; }
+    DstA = Y0<<L;
+    DstN = (Y1-Y0+1)<<L;
+    if(DstA+DstN>0x20000) { DstA=0;DstN=0x20000; }
+  }
+
   /* Command execution started */
   VDPStatus[2]|=0x01;
 
   /* Start execution if we still have time slices */
-  if(VdpEngine&&(VdpOpsCnt>0)) VdpEngine();
+  if(VdpEngine&&(VdpOpsCnt>0)) { FlushVRAM(DstA,DstN);VdpEngine();TouchVRAM(DstA,DstN); }
 
   /* Operation successfull initiated */
   return(1);
@@ -1035,12 +1059,12 @@ void LoopVDP(void)
   if(VdpOpsCnt<=0)
   {
     VdpOpsCnt+=12500;
-    if(VdpEngine&&(VdpOpsCnt>0)) VdpEngine();
+    if(VdpEngine&&(VdpOpsCnt>0)) { FlushVRAM(DstA,DstN);VdpEngine();TouchVRAM(DstA,DstN); }
   }
   else
   {
     VdpOpsCnt=12500;
-    if(VdpEngine) VdpEngine();
+    if(VdpEngine) { FlushVRAM(DstA,DstN);VdpEngine();TouchVRAM(DstA,DstN); }
   }
 }
 
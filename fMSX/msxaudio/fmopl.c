@@ -147,10 +147,11 @@ static const INT32 SL_TABLE[16]={
 /* TotalLevel : 48 24 12  6  3 1.5 0.75 (dB) */
 /* TL_TABLE[ 0      to TL_MAX          ] : plus  section */
 /* TL_TABLE[ TL_MAX to TL_MAX+TL_MAX-1 ] : minus section */
+#ifdef FMOPL_MKTABLES
 static INT32 *TL_TABLE;
 
 /* pointers to TL_TABLE with sinwave output offset */
-static INT32 **SIN_TABLE;
+static const INT32 **SIN_TABLE;
 
 /* LFO table */
 static INT32 *AMS_TABLE;
@@ -159,6 +160,11 @@ static INT32 *VIB_TABLE;
 /* envelope output curve table */
 /* attack + decay + OFF */
 static INT32 ENV_CURVE[2*EG_ENT+1];
+#else
+/* same tables, generated from this file with FMOPL_MKTABLES */
+/* defined (see fMSX.mak)                                    */
+#include "fmopltbl.h"
+#endif
 
 /* multiple table */
 #define ML 2
@@ -189,8 +195,8 @@ OPL_SLOT *SLOT7_1,*SLOT7_2,*SLOT8_1,*SLOT8_2;
 static INT32 outd[1];
 static INT32 ams;
 static INT32 vib;
-INT32  *ams_table;
-INT32  *vib_table;
+const INT32 *ams_table;
+const INT32 *vib_table;
 static INT32 amsIncr;
 static INT32 vibIncr;
 static INT32 feedback2;		/* connect for SLOT 2 */
@@ -552,6 +558,7 @@ static void init_timetables( FM_OPL *OPL , int ARRATE , int DRRATE )
 	}
 }
 
+#ifdef FMOPL_MKTABLES
 /* ---------- generic table initialize ---------- */
 static int OPLOpenTable( void )
 {
@@ -650,6 +657,7 @@ static void OPLCloseTable( void )
 	free(AMS_TABLE);
 	free(VIB_TABLE);
 }
+#endif /* FMOPL_MKTABLES */
 
 /* CSM Key Controll */
 void CSMKeyControll(OPL_CH *CH)
@@ -939,12 +947,7 @@ static int OPL_LockTable(void)
 	if(num_lock>1) return 0;
 	/* first time */
 	cur_chip = NULL;
-	/* allocate total level table (128kb space) */
-	if( !OPLOpenTable() )
-	{
-		num_lock--;
-		return -1;
-	}
+	/* common tables are const, generated at build time */
 	return 0;
 }
 
@@ -954,12 +957,30 @@ static void OPL_UnLockTable(void)
 	if(num_lock) return;
 	/* last time */
 	cur_chip = NULL;
-	OPLCloseTable();
 }
 
 
-OPLSAMPLE Y8950UpdateOne(FM_OPL *OPL)
+/* ---------- check if all slots are off and ADPCM is idle ---------- */
+static int OPLIsSilent(FM_OPL *OPL)
 {
+	OPL_CH *CH;
+	int c,s;
+
+	if( OPL->deltat->flag ) return 0;
+	for( c = 0 ; c < OPL->max_ch ; c++ )
+	{
+		CH = &OPL->P_CH[c];
+		for( s = 0 ; s < 2 ; s++ )
+			if( CH->SLOT[s].evc != EG_OFF || CH->SLOT[s].evs ) return 0;
+	}
+	return 1;
+}
+
+/* ---------- update a block of samples ---------- */
+/* return : 0 if silent, buffer is left untouched */
+int Y8950UpdateBlock(FM_OPL *OPL, OPLSAMPLE *buffer, int length)
+{
+	int i;
 	int data;
 	UINT32 amsCnt  = OPL->amsCnt;
 	UINT32 vibCnt  = OPL->vibCnt;
@@ -967,6 +988,17 @@ OPLSAMPLE Y8950UpdateOne(FM_OPL *OPL)
 	OPL_CH *CH,*R_CH;
 	YM_DELTAT *DELTAT = OPL->deltat;
 
+	/* silent : keep LFO running, flush feedback history */
+	if( OPLIsSilent(OPL) )
+	{
+		OPL->amsCnt = amsCnt + (UINT32)OPL->amsIncr*length;
+		OPL->vibCnt = vibCnt + (UINT32)OPL->vibIncr*length;
+		for( i = 0 ; i < OPL->max_ch ; i++ )
+			OPL->P_CH[i].op1_out[0] = OPL->P_CH[i].op1_out[1] = 0;
+		OPL->status &= 0xfe;
+		return 0;
+	}
+
 	/* setup DELTA-T unit */
 	YM_DELTAT_DECODE_PRESET(DELTAT);
 
@@ -987,29 +1019,40 @@ OPLSAMPLE Y8950UpdateOne(FM_OPL *OPL)
 		vib_table = OPL->vib_table;
 	}
 	R_CH = rythm ? &S_CH[6] : E_CH;
-	/*            channel A         channel B         channel C      */
-	/* LFO */
-	ams = ams_table[(amsCnt+=amsIncr)>>AMS_SHIFT];
-	vib = vib_table[(vibCnt+=vibIncr)>>VIB_SHIFT];
-	outd[0] = 0;
-	/* deltaT ADPCM */
-    if( DELTAT->flag )
-		YM_DELTAT_ADPCM_CALC(DELTAT);
-	/* FM part */
-	for(CH=S_CH ; CH < R_CH ; CH++)
-		OPL_CALC_CH(CH);
-	/* Rythn part */
-	if(rythm)
-		OPL_CALC_RH(S_CH);
-	/* limit check */
-	data = Limit( outd[0] , OPL_MAXOUT, OPL_MINOUT );
+	for( i=0; i < length ; i++ )
+	{
+		/*            channel A         channel B         channel C      */
+		/* LFO */
+		ams = ams_table[(amsCnt+=amsIncr)>>AMS_SHIFT];
+		vib = vib_table[(vibCnt+=vibIncr)>>VIB_SHIFT];
+		outd[0] = 0;
+		/* deltaT ADPCM */
+		if( DELTAT->flag )
+			YM_DELTAT_ADPCM_CALC(DELTAT);
+		/* FM part */
+		for(CH=S_CH ; CH < R_CH ; CH++)
+			OPL_CALC_CH(CH);
+		/* Rythn part */
+		if(rythm)
+			OPL_CALC_RH(S_CH);
+		/* limit check */
+		data = Limit( outd[0] , OPL_MAXOUT, OPL_MINOUT );
+		/* store to sound buffer */
+		buffer[i] = data >> OPL_OUTSB;
+	}
 	OPL->amsCnt = amsCnt;
 	OPL->vibCnt = vibCnt;
 	/* deltaT START flag */
 	if( !DELTAT->flag )
 		OPL->status &= 0xfe;
-	/* return result */
-	return data >> OPL_OUTSB;
+	return 1;
+}
+
+OPLSAMPLE Y8950UpdateOne(FM_OPL *OPL)
+{
+	OPLSAMPLE data;
+
+	return Y8950UpdateBlock(OPL, &data, 1) ? data : 0;
 }
 
 /* ---------- reset one of chip ---------- */
@@ -1174,3 +1217,35 @@ int OPLTimerOver(FM_OPL *OPL,int c)
 	/* reload timer */
 	return OPL->status>>7;
 }
+
+#ifdef FMOPL_MKTABLES
+/* ---------- table generator, builds fmopltbl.h ---------- */
+/* cc -DFMOPL_MKTABLES fmopl.c ymdeltat.c -lm               */
+static void OPLPrintTable(const char *decl,const INT32 *table,int n)
+{
+	int i;
+
+	printf("static const INT32 %s=\n{\n",decl);
+	for(i=0;i<n;i++)
+		printf("%d%s",table[i],i==n-1 ? "\n};\n\n" : (i&15)==15 ? ",\n" : ",");
+}
+
+int main(void)
+{
+	int i;
+
+	if( !OPLOpenTable() ) return 1;
+
+	printf("/* Generated by fmopl.c with FMOPL_MKTABLES, do not edit. */\n\n");
+	OPLPrintTable("TL_TABLE[TL_MAX*2]",TL_TABLE,TL_MAX*2);
+	printf("static const INT32 * const SIN_TABLE[SIN_ENT*4]=\n{\n");
+	for(i=0;i<SIN_ENT*4;i++)
+		printf("TL_TABLE+%d%s",(int)(SIN_TABLE[i]-TL_TABLE),i==SIN_ENT*4-1 ? "\n};\n\n" : (i&7)==7 ? ",\n" : ",");
+	OPLPrintTable("AMS_TABLE[AMS_ENT*2]",AMS_TABLE,AMS_ENT*2);
+	OPLPrintTable("VIB_TABLE[VIB_ENT*2]",VIB_TABLE,VIB_ENT*2);
+	OPLPrintTable("ENV_CURVE[2*EG_ENT+1]",ENV_CURVE,2*EG_ENT+1);
+
+	OPLCloseTable();
+	return 0;
+}
+#endif /* FMOPL_MKTABLES */
@@ -62,7 +62,7 @@ typedef struct fm_opl_slot {
 	UINT8 ams;		/* ams flag                            */
 	UINT8 vib;		/* vibrate flag                        */
 	/* wave selector */
-	INT32 **wavetable;
+	const INT32 * const *wavetable;
 }OPL_SLOT;
 
 /* ---------- OPL one of channel  ---------- */
@@ -110,8 +110,8 @@ typedef struct fm_opl_f {
 	INT32 DR_TABLE[75];	/* decay rate tables   */
 	UINT32 FN_TABLE[1024];  /* fnumber -> increment counter */
 	/* LFO */
-	INT32 *ams_table;
-	INT32 *vib_table;
+	const INT32 *ams_table;
+	const INT32 *vib_table;
 	INT32 amsCnt;
 	INT32 amsIncr;
 	INT32 vibCnt;
@@ -135,5 +135,6 @@ unsigned char OPLRead(FM_OPL *OPL,int a);
 int OPLTimerOver(FM_OPL *OPL,int c);
 
 INT16 Y8950UpdateOne(FM_OPL *OPL);
+int Y8950UpdateBlock(FM_OPL *OPL, OPLSAMPLE *buffer, int length);
 
 #endif
@@ -40,33 +40,29 @@ static e_uint32 voltbl[2][32]=
 } ;
 
 #define GETA_BITS 24
-static e_uint32 clk, rate, base_incr, HQ ;
 
-EMU2149_API void PSG_init(e_uint32 c, e_uint32 r)
-{
-	clk = c ;
-	rate = r ;
-  PSG_set_quality(0) ;
-}
-
-EMU2149_API void PSG_set_quality(e_uint32 q)
+EMU2149_API void PSG_set_quality(PSG *psg, e_uint32 q)
 {
   if(q)
-    base_incr = 1<<GETA_BITS ;
-  else if(rate!=0)
-    base_incr = (e_uint32)((double)clk * (1<<GETA_BITS) / (16*rate) ) ;
+    psg->base_incr = 1<<GETA_BITS ;
+  else if(psg->rate!=0)
+    psg->base_incr = (e_uint32)((double)psg->clk * (1<<GETA_BITS) / (16*psg->rate) ) ;
   /* assert( base_incr < (1<<32) ) */
 
-  HQ = q ;
+  psg->quality = q ;
 }
 
-EMU2149_API PSG *PSG_new()
+EMU2149_API PSG *PSG_new(e_uint32 c, e_uint32 r)
 {
 	PSG *psg ;
 
 	psg = malloc(sizeof(PSG)) ;
 	if( psg == NULL ) return NULL ;
 
+	psg->clk = c ;
+	psg->rate = r ;
+  PSG_set_quality(psg,0) ;
+
 	PSG_setVolumeMode(psg,EMU2149_VOL_DEFAULT) ;
 
 	return psg ;
@@ -105,8 +101,8 @@ EMU2149_API void PSG_reset(PSG *psg)
 	for(i=0;i<16;i++) psg->reg[i] = 0 ;
   psg->adr = 0 ;
 
-	psg->realstep = (e_uint32)((1<<31)/rate) ;
-	psg->psgstep =  (e_uint32)((1<<31)/(clk/16)) ;
+	psg->realstep = (e_uint32)((1<<31)/psg->rate) ;
+	psg->psgstep =  (e_uint32)((1<<31)/(psg->clk/16)) ;
 	psg->psgtime = 0 ;
 
 	psg->noise_seed = 0xffff ;
@@ -128,10 +124,6 @@ EMU2149_API void PSG_delete(PSG *psg)
 	free(psg) ;
 }
 
-EMU2149_API void PSG_close()
-{
-}
-
 EMU2149_API e_uint8 PSG_readIO(PSG *psg)
 {
   return (e_uint8)(psg->reg[psg->adr]) ;
@@ -221,7 +213,7 @@ INLINE static e_int16 calc(PSG *psg)
   e_uint32 incr ;
   e_int16 mix = 0 ;
 
-  psg->base_count += base_incr ;
+  psg->base_count += psg->base_incr ;
   incr = (psg->base_count >> GETA_BITS) ;
   psg->base_count &= (1 << GETA_BITS) - 1 ;
 
@@ -292,7 +284,7 @@ INLINE static e_int16 calc(PSG *psg)
 
 EMU2149_API e_int16 PSG_calc(PSG *psg)
 {
-  if(!HQ) return calc(psg) << 4 ;
+  if(!psg->quality) return calc(psg) << 4 ;
 
   /* Simple rate converter */
   while (psg->realstep > psg->psgtime)
@@ -307,4 +299,35 @@ EMU2149_API e_int16 PSG_calc(PSG *psg)
   return (e_int16)( psg->out << 4 ) ; 
 }
 
+/* Silent when no channel has a fixed volume above zero or follows the envelope */
+INLINE static int is_silent(PSG *psg)
+{
+  int i ;
+
+  for(i=0;i<3;i++)
+    if(!psg->mute[i]&&((psg->volume[i]&32)||psg->voltbl[psg->volume[i]&31])) return 0 ;
+
+  return 1 ;
+}
+
+EMU2149_API e_uint32 PSG_calc_block(PSG *psg, e_int16 *out, e_uint32 n)
+{
+  /* Nothing audible: leave out untouched */
+  if(is_silent(psg))
+  {
+    psg->out = 0 ;
+    return 0 ;
+  }
+
+  if(psg->quality)
+  {
+    while(n--) *out++ = PSG_calc(psg) ;
+    return 1 ;
+  }
+
+  /* calc() is inlined here, keeping psg in a register */
+  while(n--) *out++ = calc(psg) << 4 ;
+  return 1 ;
+}
+
 
@@ -46,6 +46,12 @@ typedef struct {
 	e_uint32 noise_count ;
 	e_uint32 noise_freq ;
 
+	/* Input clock, sampling rate and quality */
+	e_uint32 clk ;
+	e_uint32 rate ;
+	e_uint32 base_incr ;
+	e_uint32 quality ;
+
 	/* rate converter */
 	e_uint32 realstep ;
 	e_uint32 psgtime ;
@@ -56,10 +62,8 @@ typedef struct {
 
 } PSG ;
 	
-EMU2149_API void PSG_init(e_uint32 clk, e_uint32 rate) ;
-EMU2149_API void PSG_set_quality(e_uint32 q) ;
-EMU2149_API void PSG_close(void) ;
-EMU2149_API PSG *PSG_new(void) ;
+EMU2149_API PSG *PSG_new(e_uint32 clk, e_uint32 rate) ;
+EMU2149_API void PSG_set_quality(PSG *psg, e_uint32 q) ;
 EMU2149_API void PSG_reset(PSG *) ;
 EMU2149_API void PSG_delete(PSG *) ;
 EMU2149_API void PSG_writeReg(PSG *, e_uint32 reg, e_uint32 val) ;
@@ -67,6 +71,7 @@ EMU2149_API void PSG_writeIO(PSG *psg, e_uint32 adr, e_uint32 val) ;
 EMU2149_API e_uint8 PSG_readReg(PSG *psg, e_uint32 reg) ;
 EMU2149_API e_uint8 PSG_readIO(PSG *psg) ;
 EMU2149_API e_int16 PSG_calc(PSG *) ;
+EMU2149_API e_uint32 PSG_calc_block(PSG *, e_int16 *out, e_uint32 n) ;
 EMU2149_API void PSG_setVolumeMode(PSG *psg, int type) ;
 
 #ifdef __cplusplus
@@ -21,32 +21,27 @@
 
 #define GETA_BITS 22
 
-static e_uint32 clk, rate ,base_incr, HQ ;
-
-EMUSCC_API void SCC_init(e_uint32 c, e_uint32 r)
-{
-	clk = c ;
-	rate = r ;
-  SCC_set_quality(0) ;
-}
-
-EMUSCC_API void SCC_set_quality(e_uint32 q)
+EMUSCC_API void SCC_set_quality(SCC *scc, e_uint32 q)
 {
   if(q)
-    base_incr = 2<<GETA_BITS ;
-  else if(rate!=0)
-    base_incr = (e_uint32)((double)clk*(1<<GETA_BITS)/rate) ;
+    scc->base_incr = 2<<GETA_BITS ;
+  else if(scc->rate!=0)
+    scc->base_incr = (e_uint32)((double)scc->clk*(1<<GETA_BITS)/scc->rate) ;
 
-  HQ = q ;
+  scc->quality = q ;
 }
 
-EMUSCC_API SCC *SCC_new(void)
+EMUSCC_API SCC *SCC_new(e_uint32 c, e_uint32 r)
 {
   SCC *scc ;
 
 	scc = malloc(sizeof(SCC)) ;
 	if( scc == NULL ) return NULL ;
 
+  scc->clk = c ;
+  scc->rate = r ;
+  SCC_set_quality(scc,0) ;
+
 	return scc ;
 }
 
@@ -81,8 +76,8 @@ EMUSCC_API void SCC_reset(SCC *scc)
 
   scc->out = 0 ;
 
-	scc->realstep = (e_uint32)((1<<31)/rate) ;
-	scc->sccstep =  (e_uint32)((1<<31)/(clk/2)) ;
+	scc->realstep = (e_uint32)((1<<31)/scc->rate) ;
+	scc->sccstep =  (e_uint32)((1<<31)/(scc->clk/2)) ;
 	scc->scctime = 0 ;
 
   return ;
@@ -95,10 +90,6 @@ EMUSCC_API void SCC_delete(SCC *scc)
   if(scc!=NULL) free(scc) ;
 }
 
-EMUSCC_API void SCC_close()
-{
-}
-
 INLINE static e_int16 calc(SCC *scc)
 {
   int i ;
@@ -126,7 +117,7 @@ INLINE static e_int16 calc(SCC *scc)
 
 EMUSCC_API e_int16 SCC_calc(SCC *scc)
 {
-  if(!HQ) return calc(scc) ;
+  if(!scc->quality) return calc(scc) ;
   /* Simple rate converter */
   while (scc->realstep > scc->scctime)
   {
@@ -140,6 +131,75 @@ EMUSCC_API e_int16 SCC_calc(SCC *scc)
   return scc->out ; 
 }
 
+EMUSCC_API e_uint32 SCC_calc_block(SCC *scc, e_int16 *out, e_uint32 n)
+{
+  e_int32 mix[256] ;
+  e_uint32 i, j, m ;
+  e_uint32 count, incr, offset ;
+  e_int32 vol, rotate ;
+  e_int8 *wave ;
+  unsigned long long total ;
+
+  /* Channels at zero volume add nothing: only move their */
+  /* counters on. Skip the chip if no channel is audible.   */
+  for(i=0,j=0;i<5;i++)
+  {
+    if(!((scc->ch_enable>>i)&1)) continue ;
+    if(scc->volume[i]||scc->quality) { j++ ; continue ; }
+
+    total = (unsigned long long)scc->count[i] + (unsigned long long)scc->incr[i]*n ;
+    scc->count[i]  = (e_uint32)total & ((1<<(GETA_BITS+5))-1) ;
+    scc->offset[i] = (scc->offset[i]+31*(e_uint32)(total>>(GETA_BITS+5)))&scc->rotate[i] ;
+    scc->phase[i]  = ((scc->count[i]>>GETA_BITS)+scc->offset[i])&0x1f ;
+  }
+  if(!j) return 0 ;
+
+  if(scc->quality)
+  {
+    while(n--) *out++ = SCC_calc(scc) ;
+    return 1 ;
+  }
+
+  while(n)
+  {
+    m = (n>256)? 256 : n ;
+    for(j=0;j<m;j++) mix[j] = 0 ;
+
+    /* One channel at a time, its state held in locals */
+    for(i=0;i<5;i++)
+    {
+      if(!((scc->ch_enable>>i)&1)||!scc->volume[i]) continue ;
+
+      count  = scc->count[i] ;
+      incr   = scc->incr[i] ;
+      offset = scc->offset[i] ;
+      rotate = scc->rotate[i] ;
+      vol    = (e_int8)scc->volume[i] ;
+      wave   = scc->wave[i] ;
+
+      for(j=0;j<m;j++)
+      {
+        count += incr ;
+        if(count&(1<<(GETA_BITS+5)))
+        {
+          count &= ((1<<(GETA_BITS+5))-1) ;
+          offset = (offset+31)&rotate ;
+        }
+        mix[j] += (wave[((count>>GETA_BITS)+offset)&0x1f] * vol) >> 4 ;
+      }
+
+      scc->count[i]  = count ;
+      scc->offset[i] = offset ;
+      scc->phase[i]  = ((count>>GETA_BITS)+offset)&0x1f ;
+    }
+
+    for(j=0;j<m;j++) *out++ = (e_int16)(mix[j]<<4) ;
+    n -= m ;
+  }
+
+  return 1 ;
+}
+
 INLINE void check_enable(SCC *scc)
 {
   if((scc->save_BFFE==0x20)&&(scc->save_9000 == 0x80)) scc->enable = 2 ;
@@ -223,7 +283,7 @@ EMUSCC_API void SCC_write(SCC *scc, e_uint32 adr, e_uint32 val)
     freq = scc->freq[ch] ;
     if(scc->cycle_8bit) freq &= 0xff ;
     if(scc->cycle_4bit) freq >>= 8 ; 
-    if(freq <= 8) scc->incr[ch] = 0 ; else scc->incr[ch] = base_incr/(freq+1) ;
+    if(freq <= 8) scc->incr[ch] = 0 ; else scc->incr[ch] = scc->base_incr/(freq+1) ;
 
   }
   else if(((0x988A<=adr)&&(adr<0x988F))||((0xB8AA<=adr)&&(adr<0xB8AF)))
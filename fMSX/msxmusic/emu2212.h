@@ -25,6 +25,12 @@ typedef struct {
 
   //e_int32 buf ;
 
+  /* Input clock, sampling rate and quality */
+  e_uint32 clk ;
+  e_uint32 rate ;
+  e_uint32 base_incr ;
+  e_uint32 quality ;
+
   e_uint32 realstep ;
   e_uint32 scctime ;
   e_uint32 sccstep ;
@@ -54,15 +60,13 @@ typedef struct {
 
 } SCC ;
 
-EMUSCC_API void SCC_init(e_uint32 c, e_uint32 r);
-EMUSCC_API void SCC_set_quality(e_uint32 q) ;
-
-EMUSCC_API SCC *SCC_new(void) ;
+EMUSCC_API SCC *SCC_new(e_uint32 c, e_uint32 r) ;
+EMUSCC_API void SCC_set_quality(SCC *scc, e_uint32 q) ;
 EMUSCC_API void SCC_reset(SCC *scc) ;
 EMUSCC_API void SCC_delete(SCC *scc) ;
-EMUSCC_API void SCC_close() ;
 EMUSCC_API e_int16 SCC_calc(SCC *scc) ;
 EMUSCC_API e_int16 SCC_calcHQ(SCC *scc) ;
+EMUSCC_API e_uint32 SCC_calc_block(SCC *scc, e_int16 *out, e_uint32 n) ;
 EMUSCC_API void SCC_write(SCC *scc, e_uint32 adr, e_uint32 val) ;
 EMUSCC_API e_uint32 SCC_read(SCC *scc, e_uint32 adr) ;
 
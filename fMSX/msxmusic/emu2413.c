@@ -152,65 +152,88 @@ static unsigned char default_inst[OPLL_TONE_NUM][(16+3)*16]=
 #define EXPAND_BITS_X(x,s,d) (((x)<<((d)-(s)))|((1<<((d)-(s)))-1))
 
 /* Adjust envelope speed which depends on sampling rate. */
-#define rate_adjust(x) (rate==49716?x:(e_uint32)((double)(x)*clk/72/rate + 0.5)) /* +0.5 to round */
+#define rate_adjust(rt,x) ((rt)->rate==49716?x:(e_uint32)((double)(x)*(rt)->clk/72/(rt)->rate + 0.5)) /* +0.5 to round */
 
 #define MOD(x) ch[x]->mod
 #define CAR(x) ch[x]->car
 
-/* Sampling rate */
-static e_uint32 rate ;
-/* Input clock */
-static e_uint32 clk ;
+/* Tables depending on the input clock and the sampling rate.
+   They are shared by every OPLL running at the same clock and rate,
+   refcounted, and never written once built. */
+struct __OPLL_RATE {
+
+  /* Input clock and sampling rate */
+  e_uint32 clk ;
+  e_uint32 rate ;
+
+  e_int32 refcount ;
+  struct __OPLL_RATE *next ;
+
+  /* Phase incr table for PG */
+  e_uint32 dphaseTable[512][8][16] ;
+  /* Phase incr table for Attack */
+  e_uint32 dphaseARTable[16][16] ;
+  /* Phase incr table for Decay and Release */
+  e_uint32 dphaseDRTable[16][16] ;
+
+  e_uint32 dphaseNoiseTable[512][8] ;
+
+  /* Noise and LFO */
+  e_uint32 pm_dphase ;
+  e_uint32 am_dphase ;
+
+} ;
+
+/* Rate tables in use */
+static OPLL_RATE *rate_list = NULL ;
+
+#ifdef EMU2413_MKTABLES
 
 /* WaveTable for each envelope amp */
 static e_uint16 fullsintable[PG_WIDTH] ;
 static e_uint16 halfsintable[PG_WIDTH] ;
-
-static e_uint32 dphaseNoiseTable[512][8] ;
-
-static e_uint16 *waveform[2] = {fullsintable,halfsintable} ;
 
 /* LFO Table */
 static e_int32 pmtable[PM_PG_WIDTH] ;
 static e_int32 amtable[AM_PG_WIDTH] ;
 
-/* Noise and LFO */
-static e_uint32 pm_dphase ;
-static e_uint32 am_dphase ;
-
 /* dB to Liner table */
 static e_int16 DB2LIN_TABLE[(DB_MUTE + DB_MUTE)*2] ;
 
 /* Liner to Log curve conversion table (for Attack rate). */
 static e_uint16 AR_ADJUST_TABLE[1<<EG_BITS] ;
 
+/* KSL + TL Table */
+static e_uint32 tllTable[16][8][1<<TL_BITS][4] ;
+static e_int32 rksTable[2][8][2] ;
+
+#else
+
+/* Same tables plus default_rate, generated from this file with
+   EMU2413_MKTABLES defined (see fMSX.mak) */
+#include "2413tbl.h"
+
+#endif /* EMU2413_MKTABLES */
+
+static const e_uint16 *waveform[2] = {fullsintable,halfsintable} ;
+
 /* Empty voice data */
 static OPLL_PATCH null_patch = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } ;
 
 /* Basic voice Data */
 static OPLL_PATCH default_patch[OPLL_TONE_NUM][(16+3)*2] ; 
+static e_int32 default_patch_ready = 0 ;
 
 
 /* Definition of envelope mode */
 enum { SETTLE,ATTACK,DECAY,SUSHOLD,SUSTINE,RELEASE,FINISH } ;
 
-/* Phase incr table for Attack */
-static e_uint32 dphaseARTable[16][16] ;
-/* Phase incr table for Decay and Release */
-static e_uint32 dphaseDRTable[16][16] ;
-
-/* KSL + TL Table */
-static e_uint32 tllTable[16][8][1<<TL_BITS][4] ;
-static e_int32 rksTable[2][8][2] ;
-
-/* Phase incr table for PG */
-static e_uint32 dphaseTable[512][8][16] ; 
-
 /***************************************************
  
                   Create tables
  
 ****************************************************/
+#ifdef EMU2413_MKTABLES
 INLINE static e_int32 Min(e_int32 i,e_int32 j)
 {
   if(i<j) return i ; else return j ;
@@ -226,7 +249,6 @@ static void makeAdjustTable(void)
     AR_ADJUST_TABLE[i] = (e_uint32)((double)(1<<EG_BITS) - 1 - (1<<EG_BITS) * log(i) / log(128)) ; 
 }
 
-
 /* Table for dB(0 -- (1<<DB_BITS)) to Liner(0 -- DB2LIN_AMP_WIDTH) */
 static void makeDB2LinTable(void)
 {
@@ -246,7 +268,6 @@ static e_int32 lin2db(double d)
   if(d == 0) return (DB_MUTE - 1) ;
   else return Min(-(e_int32)(20.0*log10(d)/DB_STEP), DB_MUTE - 1) ; /* 0 -- 127 */
 }
-
 
 /* Sin Table */
 static void makeSinTable(void)
@@ -272,15 +293,6 @@ static void makeSinTable(void)
   for( i = PG_WIDTH/2 ; i< PG_WIDTH ; i++ ) halfsintable[i] = fullsintable[0] ;
 }
 
-static void makeDphaseNoiseTable(void)
-{
-  int i, j ;
-
-  for(i=0;i<512;i++)
-    for(j=0;j<8;j++)
-      dphaseNoiseTable[i][j] = rate_adjust(i<<j) ;
-}
-
 /* Table for Pitch Modulator */
 static void makePmTable(void)
 {
@@ -299,18 +311,6 @@ static void makeAmTable(void)
     amtable[i] = (e_int32)((double)AM_DEPTH/2/DB_STEP * (1.0 + sin(2.0*PI*i/PM_PG_WIDTH))) ;
 }
 
-/* Phase increment counter table */ 
-static void makeDphaseTable(void)
-{
-  e_uint32 fnum, block , ML ;
-  e_uint32 mltable[16]={ 1,1*2,2*2,3*2,4*2,5*2,6*2,7*2,8*2,9*2,10*2,10*2,12*2,12*2,15*2,15*2 } ;
-
-  for(fnum=0; fnum<512; fnum++)
-    for(block=0; block<8; block++)
-      for(ML=0; ML<16; ML++)
-        dphaseTable[fnum][block][ML] = rate_adjust(((fnum * mltable[ML])<<block)>>(20-DP_BITS)) ;
-}
-
 static void makeTllTable(void)
 {
 #define dB2(x) (e_uint32)((x)*2)
@@ -343,8 +343,47 @@ static void makeTllTable(void)
        }
 }
 
+static void makeRksTable(void)
+{
+
+  e_int32 fnum8, block, KR ;
+
+  for(fnum8 = 0 ; fnum8 < 2 ; fnum8++)
+    for(block = 0 ; block < 8 ; block++)
+      for(KR = 0; KR < 2 ; KR++)
+      {
+        if(KR!=0)
+          rksTable[fnum8][block][KR] = ( block << 1 ) + fnum8 ;
+        else
+          rksTable[fnum8][block][KR] = block >> 1 ;
+      }
+}
+
+#endif /* EMU2413_MKTABLES */
+
+static void makeDphaseNoiseTable(OPLL_RATE *rt)
+{
+  int i, j ;
+
+  for(i=0;i<512;i++)
+    for(j=0;j<8;j++)
+      rt->dphaseNoiseTable[i][j] = rate_adjust(rt,i<<j) ;
+}
+
+/* Phase increment counter table */ 
+static void makeDphaseTable(OPLL_RATE *rt)
+{
+  e_uint32 fnum, block , ML ;
+  e_uint32 mltable[16]={ 1,1*2,2*2,3*2,4*2,5*2,6*2,7*2,8*2,9*2,10*2,10*2,12*2,12*2,15*2,15*2 } ;
+
+  for(fnum=0; fnum<512; fnum++)
+    for(block=0; block<8; block++)
+      for(ML=0; ML<16; ML++)
+        rt->dphaseTable[fnum][block][ML] = rate_adjust(rt,((fnum * mltable[ML])<<block)>>(20-DP_BITS)) ;
+}
+
 /* Rate Table for Attack */
-static void makeDphaseARTable(void)
+static void makeDphaseARTable(OPLL_RATE *rt)
 {
   e_int32 AR,Rks,RM,RL ;
 
@@ -357,20 +396,20 @@ static void makeDphaseARTable(void)
       switch(AR)
       { 
         case 0:
-          dphaseARTable[AR][Rks] = 0 ;
+          rt->dphaseARTable[AR][Rks] = 0 ;
           break ;
         case 15:
-          dphaseARTable[AR][Rks] = EG_DP_WIDTH ;
+          rt->dphaseARTable[AR][Rks] = EG_DP_WIDTH ;
           break ;
         default:
-          dphaseARTable[AR][Rks] = rate_adjust(( 3 * (RL + 4) << (RM + 1))) ;
+          rt->dphaseARTable[AR][Rks] = rate_adjust(rt,( 3 * (RL + 4) << (RM + 1))) ;
           break ;
       }
     }
 }
 
 /* Rate Table for Decay */
-static void makeDphaseDRTable(void)
+static void makeDphaseDRTable(OPLL_RATE *rt)
 {
   e_int32 DR,Rks,RM,RL ;
 
@@ -383,31 +422,15 @@ static void makeDphaseDRTable(void)
       switch(DR)
       { 
         case 0:
-          dphaseDRTable[DR][Rks] = 0 ;
+          rt->dphaseDRTable[DR][Rks] = 0 ;
           break ;
         default:
-          dphaseDRTable[DR][Rks] = rate_adjust((RL + 4) << (RM - 1));
+          rt->dphaseDRTable[DR][Rks] = rate_adjust(rt,(RL + 4) << (RM - 1));
           break ;
       }
     }
 }
 
-static void makeRksTable(void)
-{
-
-  e_int32 fnum8, block, KR ;
-
-  for(fnum8 = 0 ; fnum8 < 2 ; fnum8++)
-    for(block = 0 ; block < 8 ; block++)
-      for(KR = 0; KR < 2 ; KR++)
-      {
-        if(KR!=0)
-          rksTable[fnum8][block][KR] = ( block << 1 ) + fnum8 ;
-        else
-          rksTable[fnum8][block][KR] = block >> 1 ;
-      }
-}
-
 void OPLL_dump2patch(const e_uint8 *dump, OPLL_PATCH *patch)
 {
   patch[0].AM = (dump[0]>>7)&1 ;
@@ -498,24 +521,24 @@ INLINE static e_uint32 calc_eg_dphase(OPLL_SLOT *slot)
   switch(slot->eg_mode)
   {
     case ATTACK:
-      return dphaseARTable[slot->patch->AR][slot->rks] ;
+      return slot->rt->dphaseARTable[slot->patch->AR][slot->rks] ;
   
     case DECAY:
-      return dphaseDRTable[slot->patch->DR][slot->rks] ;
+      return slot->rt->dphaseDRTable[slot->patch->DR][slot->rks] ;
   
     case SUSHOLD:
       return 0 ;
 
     case SUSTINE:
-      return dphaseDRTable[slot->patch->RR][slot->rks] ;
+      return slot->rt->dphaseDRTable[slot->patch->RR][slot->rks] ;
   
     case RELEASE:
       if(slot->sustine)
-        return dphaseDRTable[5][slot->rks] ;
+        return slot->rt->dphaseDRTable[5][slot->rks] ;
       else if(slot->patch->EG)
-        return dphaseDRTable[slot->patch->RR][slot->rks] ;
+        return slot->rt->dphaseDRTable[slot->patch->RR][slot->rks] ;
       else 
-        return dphaseDRTable[7][slot->rks] ;
+        return slot->rt->dphaseDRTable[7][slot->rks] ;
 
     case FINISH:
       return 0 ;
@@ -537,7 +560,7 @@ INLINE static e_uint32 calc_eg_dphase(OPLL_SLOT *slot)
 #define SLOT_TOM 16
 #define SLOT_CYM 17
 
-#define UPDATE_PG(S)  (S)->dphase = dphaseTable[(S)->fnum][(S)->block][(S)->patch->ML]
+#define UPDATE_PG(S)  (S)->dphase = (S)->rt->dphaseTable[(S)->fnum][(S)->block][(S)->patch->ML]
 #define UPDATE_TLL(S)\
 (((S)->type==0)?\
 ((S)->tll = tllTable[((S)->fnum)>>5][(S)->block][(S)->patch->TL][(S)->patch->KL]):\
@@ -799,23 +822,97 @@ static void OPLL_CH_delete(OPLL_CH *ch)
   free(ch) ;
 }
 
+/* Find or build the rate tables for clock c and rate r. */
+static const OPLL_RATE *OPLL_RATE_get(e_uint32 c, e_uint32 r)
+{
+  OPLL_RATE *rt ;
+
+#ifndef EMU2413_MKTABLES
+  if((c == EMU2413_TABLE_CLK)&&(r == EMU2413_TABLE_RATE)) return &default_rate ;
+#endif
 
-OPLL *OPLL_new(void)
+  for(rt = rate_list ; rt != NULL ; rt = rt->next)
+    if((rt->clk == c)&&(rt->rate == r))
+    {
+      rt->refcount++ ;
+      return rt ;
+    }
+
+  rt = malloc(sizeof(OPLL_RATE)) ;
+  if(rt == NULL) return NULL ;
+
+  rt->clk = c ;
+  rt->rate = r ;
+  makeDphaseTable(rt) ;
+  makeDphaseARTable(rt) ;
+  makeDphaseDRTable(rt) ;
+  makeDphaseNoiseTable(rt) ;
+  rt->pm_dphase = (e_uint32)rate_adjust(rt, PM_SPEED * PM_DP_WIDTH / (c/72) ) ;
+  rt->am_dphase = (e_uint32)rate_adjust(rt, AM_SPEED * AM_DP_WIDTH / (c/72) ) ;
+
+  rt->refcount = 1 ;
+  rt->next = rate_list ;
+  rate_list = rt ;
+
+  return rt ;
+}
+
+/* Drop a reference, freeing the tables with the last one. */
+static void OPLL_RATE_release(const OPLL_RATE *rt)
+{
+  OPLL_RATE **p, *q ;
+
+  for(p = &rate_list ; *p != NULL ; p = &(*p)->next)
+    if(*p == rt)
+    {
+      q = *p ;
+      if(--q->refcount > 0) return ;
+      *p = q->next ;
+      free(q) ;
+      return ;
+    }
+}
+
+/* Point opll and its slots at rt. */
+static void setRate(OPLL *opll, const OPLL_RATE *rt)
+{
+  e_int32 i ;
+
+  opll->rt = rt ;
+  for ( i = 0 ; i < 18 ; i++ ) opll->slot[i]->rt = rt ;
+}
+
+OPLL *OPLL_new(e_uint32 c, e_uint32 r)
 {
   OPLL *opll ;
   OPLL_CH *ch[9] ;
   OPLL_PATCH *patch[19*2] ;
+  const OPLL_RATE *rt ;
   e_int32 i, j ;
 
+  if(!default_patch_ready)
+  {
+    makeDefaultPatch() ;
+    default_patch_ready = 1 ;
+  }
+
   opll = calloc(sizeof(OPLL),1) ;
   if(opll == NULL) return NULL ;
+
+  rt = OPLL_RATE_get(c,r) ;
+  if(rt == NULL)
+  {
+    free(opll) ;
+    return NULL ;
+  }
 
   for( i = 0 ; i < 19*2 ; i++ )
   {
     patch[i] = calloc(sizeof(OPLL_PATCH),1) ;
     if(patch[i] == NULL)
     {
-      for ( j = i ; i > 0 ; i++ ) free(patch[j-1]) ;
+      for ( j = i ; j > 0 ; j-- ) free(patch[j-1]) ;
+      OPLL_RATE_release(rt) ;
       free(opll) ;
       return NULL ;
     }
@@ -826,8 +923,9 @@ OPLL *OPLL_new(void)
     ch[i] = OPLL_CH_new() ;
     if(ch[i]==NULL)
     {
-      for ( j = i ; i > 0 ; i++ ) OPLL_CH_delete(ch[j-1]) ;
+      for ( j = i ; j > 0 ; j-- ) OPLL_CH_delete(ch[j-1]) ;
       for ( j = 0 ; j < 19*2 ; j++ ) free(patch[j]) ;
+      OPLL_RATE_release(rt) ;
       free(opll) ;
       return NULL ;
     }
@@ -849,6 +947,8 @@ OPLL *OPLL_new(void)
     opll->slot[i]->plfo_pm = &opll->lfo_pm ;
   }
 
+  setRate(opll,rt) ;
+
   opll->mask = 0 ;
 
   OPLL_reset(opll) ;
@@ -869,6 +969,8 @@ void OPLL_delete(OPLL *opll)
   for ( i = 0 ; i < 19*2 ; i++ )
     free(opll->patch[i]) ;
 
+  OPLL_RATE_release(opll->rt) ;
+
   free(opll) ;
 }
 
@@ -917,33 +1019,23 @@ void OPLL_reset(OPLL *opll)
 
 }
 
-void OPLL_setClock(e_uint32 c, e_uint32 r)
+/* Change clock and rate during play. Keeps the old ones on failure. */
+void OPLL_setClock(OPLL *opll, e_uint32 c, e_uint32 r)
 {
-  clk = c ;
-  rate = r ;
-  makeDphaseTable() ;
-  makeDphaseARTable() ;
-  makeDphaseDRTable() ;
-  makeDphaseNoiseTable() ;
-  pm_dphase = (e_uint32)rate_adjust(PM_SPEED * PM_DP_WIDTH / (clk/72) ) ;
-  am_dphase = (e_uint32)rate_adjust(AM_SPEED * AM_DP_WIDTH / (clk/72) ) ;
-}
+  const OPLL_RATE *rt ;
 
-void OPLL_init(e_uint32 c, e_uint32 r)
-{
-  makePmTable() ;
-  makeAmTable() ;
-  makeDB2LinTable() ; 
-  makeAdjustTable() ;
-  makeTllTable() ;
-  makeRksTable() ;
-  makeSinTable() ;
-  makeDefaultPatch() ;
-  OPLL_setClock(c,r) ;
-}
+  if(opll==NULL) return ;
+  if((opll->rt->clk == c)&&(opll->rt->rate == r)) return ;
 
-void OPLL_close(void)
-{
+  rt = OPLL_RATE_get(c,r) ;
+  if(rt == NULL) return ;
+
+  OPLL_RATE_release(opll->rt) ;
+  setRate(opll,rt) ;
+
+  OPLL_forceRefresh(opll) ;
+  opll->noiseA_dphase = rt->dphaseNoiseTable[((opll->reg[0x27]&1)<<8) + opll->reg[0x17]][(opll->reg[0x27]>>1)&7] ;
+  opll->noiseB_dphase = rt->dphaseNoiseTable[((opll->reg[0x28]&1)<<8) + opll->reg[0x18]][(opll->reg[0x28]>>1)&7] ;
 }
 
 /*********************************************************
@@ -1009,8 +1101,8 @@ INLINE static void update_noise(OPLL *opll)
 /* Update AM, PM unit */
 INLINE static void update_ampm(OPLL *opll)
 {
-  opll->pm_phase = (opll->pm_phase + pm_dphase)&(PM_DP_WIDTH - 1) ;
-  opll->am_phase = (opll->am_phase + am_dphase)&(AM_DP_WIDTH - 1) ;
+  opll->pm_phase = (opll->pm_phase + opll->rt->pm_dphase)&(PM_DP_WIDTH - 1) ;
+  opll->am_phase = (opll->am_phase + opll->rt->am_dphase)&(AM_DP_WIDTH - 1) ;
   opll->lfo_am = amtable[HIGHBITS(opll->am_phase, AM_DP_BITS - AM_PG_BITS)] ;
   opll->lfo_pm = pmtable[HIGHBITS(opll->pm_phase, PM_DP_BITS - PM_PG_BITS)] ;
 }
@@ -1218,7 +1310,27 @@ INLINE static e_int32 calc_slot_hat(OPLL_SLOT *slot, e_int32 a, e_int32 b, e_uin
   }
 }
 
-e_int16 OPLL_calc(OPLL *opll)
+/* A slot is silent once its envelope has finished, or while it waits */
+/* for its first key-on without a frequency and its output has drained */
+#define SLOT_SILENT(S) (((S)->eg_mode==FINISH)||(((S)->eg_mode==SETTLE)&&!(S)->dphase&&!(S)->output[0]&&!(S)->output[1]))
+
+INLINE static e_int32 is_silent(OPLL *opll)
+{
+  e_int32 i ;
+
+  for(i = 0 ; i < (opll->rythm_mode? 6:9) ; i++)
+    if(!(opll->mask&OPLL_MASK_CH(i))&&!SLOT_SILENT(opll->CAR(i))) return 0 ;
+
+  if(opll->rythm_mode)
+  {
+    if(!SLOT_SILENT(opll->CAR(6))||!SLOT_SILENT(opll->CAR(7))||!SLOT_SILENT(opll->CAR(8))) return 0 ;
+    if(!SLOT_SILENT(opll->MOD(7))||!SLOT_SILENT(opll->MOD(8))) return 0 ;
+  }
+
+  return 1 ;
+}
+
+INLINE static e_int16 calc(OPLL *opll)
 {
   e_int32 inst = 0 , perc = 0 , out = 0 ;
   e_int32 i ;
@@ -1227,13 +1339,13 @@ e_int16 OPLL_calc(OPLL *opll)
   update_noise(opll) ;
 
   for(i = 0 ; i < 6 ; i++)
-    if(!(opll->mask&OPLL_MASK_CH(i))&&(opll->CAR(i)->eg_mode!=FINISH))
+    if(!(opll->mask&OPLL_MASK_CH(i))&&!SLOT_SILENT(opll->CAR(i)))
       inst += calc_slot_car(opll->CAR(i),calc_slot_mod(opll->MOD(i))) ;
 
   if(!opll->rythm_mode)
   {
     for(i = 6 ; i < 9 ; i++)
-      if(!(opll->mask&OPLL_MASK_CH(i))&&(opll->CAR(i)->eg_mode!=FINISH))
+      if(!(opll->mask&OPLL_MASK_CH(i))&&!SLOT_SILENT(opll->CAR(i)))
         inst += calc_slot_car(opll->CAR(i),calc_slot_mod(opll->MOD(i))) ;
   }
   else
@@ -1267,6 +1379,25 @@ e_int16 OPLL_calc(OPLL *opll)
 
 }
 
+e_int16 OPLL_calc(OPLL *opll)
+{
+  return calc(opll) ;
+}
+
+e_uint32 OPLL_calc_block(OPLL *opll, e_int16 *out, e_uint32 n)
+{
+  /* Nothing audible: keep the LFOs running, leave out untouched */
+  if(is_silent(opll))
+  {
+    opll->pm_phase = (opll->pm_phase + n*opll->rt->pm_dphase)&(PM_DP_WIDTH - 1) ;
+    opll->am_phase = (opll->am_phase + n*opll->rt->am_dphase)&(AM_DP_WIDTH - 1) ;
+    return 0 ;
+  }
+
+  while(n--) *out++ = calc(opll) ;
+  return 1 ;
+}
+
 e_uint32 OPLL_setMask(OPLL *opll, e_uint32 mask)
 {
   e_uint32 ret ;
@@ -1473,10 +1604,10 @@ void OPLL_writeReg(OPLL *opll, e_uint32 reg, e_uint32 data){
       switch(reg)
       {
       case 0x17:
-        opll->noiseA_dphase = dphaseNoiseTable[data + ((opll->reg[0x27]&1)<<8)][(opll->reg[0x27]>>1)&7] ;
+        opll->noiseA_dphase = opll->rt->dphaseNoiseTable[data + ((opll->reg[0x27]&1)<<8)][(opll->reg[0x27]>>1)&7] ;
         break ;
       case 0x18:
-        opll->noiseB_dphase = dphaseNoiseTable[data + ((opll->reg[0x28]&1)<<8)][(opll->reg[0x28]>>1)&7] ;
+        opll->noiseB_dphase = opll->rt->dphaseNoiseTable[data + ((opll->reg[0x28]&1)<<8)][(opll->reg[0x28]>>1)&7] ;
         break;
       default:
         break ;
@@ -1503,7 +1634,7 @@ void OPLL_writeReg(OPLL *opll, e_uint32 reg, e_uint32 data){
         break ;
       
       case 0x27:
-        opll->noiseA_dphase = dphaseNoiseTable[((data&1)<<8) + opll->reg[0x17]][(data>>1)&7] ;
+        opll->noiseA_dphase = opll->rt->dphaseNoiseTable[((data&1)<<8) + opll->reg[0x17]][(data>>1)&7] ;
         if(opll->rythm_mode)
         {
           opll->slot_on_flag[SLOT_SD]  |= (opll->reg[0x0e])&0x08 ;
@@ -1512,7 +1643,7 @@ void OPLL_writeReg(OPLL *opll, e_uint32 reg, e_uint32 data){
         break;
 
       case 0x28:
-        opll->noiseB_dphase = dphaseNoiseTable[((data&1)<<8) + opll->reg[0x18]][(data>>1)&7] ;
+        opll->noiseB_dphase = opll->rt->dphaseNoiseTable[((data&1)<<8) + opll->reg[0x18]][(data>>1)&7] ;
         if(opll->rythm_mode)
         {
           opll->slot_on_flag[SLOT_TOM] |= (opll->reg[0x0e])&0x04 ;
@@ -1570,3 +1701,92 @@ void OPLL_writeIO(OPLL *opll, e_uint32 adr, e_uint32 val)
   if(adr & 1) OPLL_writeReg(opll, opll->adr, val) ;
   else opll->adr = val ;
 }
+
+#ifdef EMU2413_MKTABLES
+/***********************************************************
+
+      Table generator, builds 2413tbl.h for the default
+      clock and rate: cc -DEMU2413_MKTABLES emu2413.c -lm
+
+***********************************************************/
+#define MKTABLES_CLK 3579545
+#define MKTABLES_RATE 44100
+
+/* Print a table of s byte values as a C initializer, with */
+/* one level of braces for each of its dims dimensions.    */
+static void printTable(const void *p, e_int32 s, e_int32 sign, const e_int32 *dim, e_int32 dims)
+{
+  e_int32 i, j, n, span ;
+  long v ;
+
+  for(n = 1, j = 0 ; j < dims ; j++) n *= dim[j] ;
+
+  for(i = 0 ; i < n ; i++)
+  {
+    for(span = n, j = 0 ; j < dims ; span /= dim[j++])
+      if(!(i%span)) printf("{") ;
+
+    if(s == 2)
+      v = sign ? ((const e_int16 *)p)[i] : ((const e_uint16 *)p)[i] ;
+    else
+      v = sign ? ((const e_int32 *)p)[i] : (long)((const e_uint32 *)p)[i] ;
+    printf("%ld", v) ;
+
+    for(span = 1, j = dims - 1 ; j >= 0 ; j--)
+    {
+      span *= dim[j] ;
+      if(!((i+1)%span)) printf("}") ;
+    }
+
+    if(i+1 < n) printf(((i+1)%16)&&((i+1)%dim[dims-1]) ? "," : ",\n") ;
+  }
+}
+
+static void printDecl(const char *decl, const void *p, e_int32 s, e_int32 sign, const e_int32 *dim, e_int32 dims)
+{
+  printf("static const %s =\n", decl) ;
+  printTable(p, s, sign, dim, dims) ;
+  printf(" ;\n\n") ;
+}
+
+int main(void)
+{
+  const OPLL_RATE *rt ;
+
+  makePmTable() ;
+  makeAmTable() ;
+  makeDB2LinTable() ;
+  makeAdjustTable() ;
+  makeTllTable() ;
+  makeRksTable() ;
+  makeSinTable() ;
+
+  rt = OPLL_RATE_get(MKTABLES_CLK, MKTABLES_RATE) ;
+  if(rt == NULL) return 1 ;
+
+  printf("/* Generated by emu2413.c with EMU2413_MKTABLES, do not edit. */\n\n") ;
+  printf("#define EMU2413_TABLE_CLK %d\n", MKTABLES_CLK) ;
+  printf("#define EMU2413_TABLE_RATE %d\n\n", MKTABLES_RATE) ;
+
+  printDecl("e_uint16 fullsintable[PG_WIDTH]", fullsintable, 2, 0, (const e_int32[]){ PG_WIDTH }, 1) ;
+  printDecl("e_uint16 halfsintable[PG_WIDTH]", halfsintable, 2, 0, (const e_int32[]){ PG_WIDTH }, 1) ;
+  printDecl("e_int32 pmtable[PM_PG_WIDTH]", pmtable, 4, 1, (const e_int32[]){ PM_PG_WIDTH }, 1) ;
+  printDecl("e_int32 amtable[AM_PG_WIDTH]", amtable, 4, 1, (const e_int32[]){ AM_PG_WIDTH }, 1) ;
+  printDecl("e_int16 DB2LIN_TABLE[(DB_MUTE + DB_MUTE)*2]", DB2LIN_TABLE, 2, 1, (const e_int32[]){ (DB_MUTE + DB_MUTE)*2 }, 1) ;
+  printDecl("e_uint16 AR_ADJUST_TABLE[1<<EG_BITS]", AR_ADJUST_TABLE, 2, 0, (const e_int32[]){ 1<<EG_BITS }, 1) ;
+  printDecl("e_uint32 tllTable[16][8][1<<TL_BITS][4]", tllTable, 4, 0, (const e_int32[]){ 16, 8, 1<<TL_BITS, 4 }, 4) ;
+  printDecl("e_int32 rksTable[2][8][2]", rksTable, 4, 1, (const e_int32[]){ 2, 8, 2 }, 3) ;
+
+  printf("static const OPLL_RATE default_rate =\n{\n%lu, %lu, 0, NULL,\n", (unsigned long)rt->clk, (unsigned long)rt->rate) ;
+  printTable(rt->dphaseTable, 4, 0, (const e_int32[]){ 512, 8, 16 }, 3) ;
+  printf(",\n") ;
+  printTable(rt->dphaseARTable, 4, 0, (const e_int32[]){ 16, 16 }, 2) ;
+  printf(",\n") ;
+  printTable(rt->dphaseDRTable, 4, 0, (const e_int32[]){ 16, 16 }, 2) ;
+  printf(",\n") ;
+  printTable(rt->dphaseNoiseTable, 4, 0, (const e_int32[]){ 512, 8 }, 2) ;
+  printf(",\n%lu, %lu\n} ;\n", (unsigned long)rt->pm_dphase, (unsigned long)rt->am_dphase) ;
+
+  return 0 ;
+}
+#endif /* EMU2413_MKTABLES */
@@ -24,11 +24,16 @@ typedef struct {
   e_uint32 TL,FB,EG,ML,AR,DR,SL,RR,KR,KL,AM,PM,WF ;
 } OPLL_PATCH ;
 
+/* Clock and rate dependent tables, shared between OPLLs */
+typedef struct __OPLL_RATE OPLL_RATE ;
+
 /* slot */
 typedef struct {
 
   OPLL_PATCH *patch;  
 
+  const OPLL_RATE *rt ;   /* refer to opll->rt */
+
   e_int32 type ;          /* 0 : modulator 1 : carrier */
 
   /* OUTPUT */
@@ -36,7 +41,7 @@ typedef struct {
   e_int32 output[5] ;      /* Output value of slot */
 
   /* for Phase Generator (PG) */
-  e_uint16 *sintbl ;    /* Wavetable */
+  const e_uint16 *sintbl ; /* Wavetable */
   e_uint32 phase ;      /* Phase */
   e_uint32 dphase ;     /* Phase increment amount */
   e_uint32 pgout ;      /* output */
@@ -122,20 +127,20 @@ typedef struct {
 
   e_uint32 mask ;
 
-} OPLL ;
+  /* Clock and rate dependent tables */
+  const OPLL_RATE *rt ;
 
-/* Initialize */
-EMU2413_API void OPLL_init(e_uint32 clk, e_uint32 rate) ;
-EMU2413_API void OPLL_close(void) ;
+} OPLL ;
 
-/* Create Object */
-EMU2413_API OPLL *OPLL_new(void) ;
+/* Create Object (OPLL_new, OPLL_delete and OPLL_setClock update the
+   tables shared between OPLLs and must not run concurrently) */
+EMU2413_API OPLL *OPLL_new(e_uint32 clk, e_uint32 rate) ;
 EMU2413_API void OPLL_delete(OPLL *) ;
 
 /* Setup */
 EMU2413_API void OPLL_reset(OPLL *) ;
 EMU2413_API void OPLL_reset_patch(OPLL *, e_int32) ;
-EMU2413_API void OPLL_setClock(e_uint32 c, e_uint32 r) ;
+EMU2413_API void OPLL_setClock(OPLL *, e_uint32 c, e_uint32 r) ;
 
 /* Port/Register access */
 EMU2413_API void OPLL_writeIO(OPLL *, e_uint32 reg, e_uint32 val) ;
@@ -143,6 +148,7 @@ EMU2413_API void OPLL_writeReg(OPLL *, e_uint32 reg, e_uint32 val) ;
 
 /* Synthsize */
 EMU2413_API e_int16 OPLL_calc(OPLL *) ;
+EMU2413_API e_uint32 OPLL_calc_block(OPLL *, e_int16 *out, e_uint32 n) ;
 
 /* Misc */
 EMU2413_API void OPLL_setPatch(OPLL *, const e_uint8 *dump) ;
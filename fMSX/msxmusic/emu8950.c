@@ -577,7 +577,7 @@ OPL *OPL_new(void)
     ch[i] = OPL_CH_new() ;
     if(ch[i]==NULL)
     {
-      for ( j = i ; i > 0 ; i++ ) OPL_CH_delete(ch[j-1]) ;
+      for ( j = i ; j > 0 ; j-- ) OPL_CH_delete(ch[j-1]) ;
       free(opl) ;
       return NULL ;
     }
@@ -629,7 +629,7 @@ void OPL_reset(OPL *opl)
   opl->am_phase = 0 ;
   opl->noise_seed =0xffff ;
 
-  for ( i = 0 ; i < 0xFF ; i++ ) opl->reg[i] = 0x00 ;
+  for ( i = 0 ; i < 0x100 ; i++ ) opl->reg[i] = 0x00 ;
   for( i = 0 ; i < 18 ; i++ ) opl->slot_on_flag[i] = 0 ;
 
   ADPCM_reset(opl->adpcm);
@@ -882,6 +882,31 @@ e_int16 OPL_calc(OPL *opl)
 
 }
 
+/* Silent when every computed channel has finished and ADPCM is idle */
+INLINE static e_int32 is_silent(OPL *opl)
+{
+  e_int32 i ;
+
+  for(i = 0 ; i < (opl->rythm_mode? 6:9) ; i++)
+    if((!opl->mask[i])&&(opl->CAR(i)->eg_mode!=FINISH)) return 0 ;
+
+  return ADPCM_isSilent(opl->adpcm) ;
+}
+
+e_uint32 OPL_calc_block(OPL *opl, e_int16 *out, e_uint32 n)
+{
+  /* Nothing audible: keep the LFOs running, leave out untouched */
+  if(is_silent(opl))
+  {
+    opl->pm_phase = (opl->pm_phase + n*pm_dphase)&(PM_DP_WIDTH - 1) ;
+    opl->am_phase = (opl->am_phase + n*am_dphase)&(AM_DP_WIDTH - 1) ;
+    return 0 ;
+  }
+
+  while(n--) *out++ = OPL_calc(opl) ;
+  return 1 ;
+}
+
 void OPL_writeReg(OPL *opl, e_uint32 reg, e_uint32 data)
 {
 
@@ -76,7 +76,7 @@ typedef struct {
   e_int32 output[2] ;
 
   /* Register */
-  unsigned char reg[0xff] ; 
+  unsigned char reg[0x100] ; 
   e_int32 slot_on_flag[18] ;
 
   /* Rythm Mode : 0 = OFF, 1 = ON */
@@ -108,6 +108,7 @@ EMU8950_API void OPL_reset(OPL *opl) ;
 EMU8950_API void OPL_delete(OPL *opl) ;
 EMU8950_API void OPL_writeReg(OPL *opl, e_uint32 reg, e_uint32 val) ;
 EMU8950_API e_int16 OPL_calc(OPL *opl) ;
+EMU8950_API e_uint32 OPL_calc_block(OPL *opl, e_int16 *out, e_uint32 n) ;
 EMU8950_API void OPL_writeIO(OPL *opl, e_uint32 adr, e_uint32 val) ;
 EMU8950_API e_uint32 OPL_readIO(OPL *opl) ;
 EMU8950_API e_uint32 OPL_status(OPL *opl) ;
@@ -4,6 +4,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "emuadpcm.h"
 #include "assert.h"
 
@@ -239,7 +240,7 @@ EMU8950_ADPCM_API void ADPCM_writeReg(ADPCM *_this, e_uint32 adr, e_uint32 data)
     {
       _this->reg[0x04] = data ;
     }
-    assert(_this->reg[0x04]&0x80 == 0);
+    assert((_this->reg[0x04]&0x80) == 0);
     break;
 
   case 0x05: /* (KEYBOARD IN) */
@@ -328,3 +329,11 @@ EMU8950_ADPCM_API e_uint32 ADPCM_status(ADPCM *_this)
 {
   return _this->status;
 }
+
+/* Silent when not playing and the held output level is zero */
+EMU8950_ADPCM_API e_uint32 ADPCM_isSilent(ADPCM *_this)
+{
+  if(_this->reg[0x07]&R07_SP_OFF) return 1;
+  if(_this->play_start) return 0;
+  return !(((_this->output[0] + _this->output[1]) * (_this->reg[0x12]&0xff)) >> 13);
+}
@@ -48,5 +48,6 @@ EMU8950_ADPCM_API void ADPCM_delete(ADPCM *);
 EMU8950_ADPCM_API void ADPCM_writeReg(ADPCM *, e_uint32 reg, e_uint32 val);
 EMU8950_ADPCM_API e_int16 ADPCM_calc(ADPCM *);
 EMU8950_ADPCM_API e_uint32 ADPCM_status(ADPCM *);
+EMU8950_ADPCM_API e_uint32 ADPCM_isSilent(ADPCM *);
 
 #endif
\ No newline at end of file
@@ -69,8 +69,7 @@ int main(void){
   chunkID(header+36,"data") ;
   DWORD(header+40,2*DATALENGTH) ;
 
-  OPLL_init(MSX_CLK,SAMPLERATE) ;
-  opll = OPLL_new() ;
+  opll = OPLL_new(MSX_CLK,SAMPLERATE) ;
   OPLL_reset(opll) ;
   OPLL_reset_patch(opll,0) ;            /* if use default voice data. */ 
 
@@ -86,7 +85,6 @@ int main(void){
   finish = clock() ;
 
   OPLL_delete(opll) ;
-  OPLL_close() ;
 
   printf("It has been %f sec to calc %d waves.\n",
 	 (double)(finish-start)/CLOCKS_PER_SEC, DATALENGTH) ;
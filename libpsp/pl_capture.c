@@ -0,0 +1,338 @@
+/* psplib/pl_capture.c: Background frame and audio capture
+   Copyright (C) 2007-2009 Akop Karapetyan
+
+   $Id$
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Author contact information: 
+     Email: dev@psp.akop.org
+*/
+
+
+#include <pspkernel.h>
+#include <pspthreadman.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "pl_capture.h"
+#include "pl_file.h"
+
+#define DEFAULT_FRAME_SLOTS 8
+#define SAMPLE_SECONDS      2
+#define IDLE_DELAY_US       10000
+
+static volatile int capture_active;
+static volatile int capture_stop;
+static int thread_handle = -1;
+static int frame_sema = -1;
+
+static PspImage **frames;
+static int frame_slots;
+static volatile unsigned int frame_head, frame_tail;
+static volatile unsigned int frames_dropped;
+static unsigned int frames_written;
+
+static short *samples;
+static unsigned int sample_slots;
+static volatile unsigned int sample_head, sample_tail;
+static volatile unsigned int samples_dropped;
+static volatile int samples_busy; /* Audio thread is in put_samples */
+static unsigned int sample_rate;
+
+static FILE *wav_file;
+static unsigned int wav_bytes;
+static pl_file_path capture_path;
+
+static int  capture_thread(int args, void *argp);
+static void write_wav_header(FILE *file, unsigned int data_bytes);
+static void flush_samples();
+static void free_buffers();
+
+int pl_capture_start(const char *path,
+                     const char *prefix,
+                     int max_width,
+                     int max_height,
+                     int slots,
+                     int rate)
+{
+  int i;
+  pl_file_path wav_path;
+
+  if (capture_active) return 0;
+
+  /* If capture path does not exist, create it */
+  if (!pl_file_exists(path))
+    if (!pl_file_mkdir_recursive(path))
+      return 0;
+
+  /* Find first unused session number */
+  i = 0;
+  do
+  {
+    snprintf(wav_path, sizeof(wav_path) - 1, "%s%s-%02i.wav", path, prefix, i);
+  } while (pl_file_exists(wav_path) && ++i < 100);
+  snprintf(capture_path, sizeof(capture_path) - 1, "%s%s-%02i", path, prefix, i);
+
+  /* Allocate frame ring */
+  frame_slots = (slots > 0) ? slots : DEFAULT_FRAME_SLOTS;
+  if (!(frames = (PspImage**)calloc(frame_slots, sizeof(PspImage*))))
+    return 0;
+  for (i = 0; i < frame_slots; i++)
+    if (!(frames[i] = pspImageCreate(max_width, max_height, PSP_IMAGE_16BPP)))
+    {
+      free_buffers();
+      return 0;
+    }
+
+  /* Allocate sample ring and the WAV file */
+  sample_rate = rate;
+  sample_slots = (rate > 0) ? rate * SAMPLE_SECONDS : 0;
+  if (sample_slots)
+  {
+    if (!(samples = (short*)malloc(sample_slots * sizeof(short)))
+      || !(wav_file = fopen(wav_path, "wb")))
+    {
+      free_buffers();
+      return 0;
+    }
+
+    /* Sizes are filled in by pl_capture_stop() */
+    write_wav_header(wav_file, 0);
+  }
+
+  frame_head = frame_tail = 0;
+  sample_head = sample_tail = 0;
+  frames_dropped = samples_dropped = 0;
+  frames_written = wav_bytes = 0;
+  capture_stop = 0;
+
+  /* Encoder runs at a lower priority than emulation and sound */
+  frame_sema = sceKernelCreateSema("capture", 0, 0, frame_slots, NULL);
+  thread_handle = sceKernelCreateThread("capture",
+    (void*)&capture_thread, 0x30, 0x10000, 0, NULL);
+
+  if (frame_sema < 0 || thread_handle < 0
+    || sceKernelStartThread(thread_handle, 0, NULL) != 0)
+  {
+    if (thread_handle >= 0) sceKernelDeleteThread(thread_handle);
+    if (frame_sema >= 0) sceKernelDeleteSema(frame_sema);
+    thread_handle = frame_sema = -1;
+    free_buffers();
+    return 0;
+  }
+
+  capture_active = 1;
+  return 1;
+}
+
+void pl_capture_stop()
+{
+  if (!capture_active) return;
+  capture_active = 0;
+
+  /* The audio thread may be copying into the sample ring; it
+     sees capture_active cleared on its next call */
+  while (samples_busy)
+    sceKernelDelayThread(1000);
+
+  /* Let the encoder drain what was queued, then exit */
+  capture_stop = 1;
+  sceKernelSignalSema(frame_sema, 1);
+  sceKernelWaitThreadEnd(thread_handle, NULL);
+  sceKernelDeleteThread(thread_handle);
+  sceKernelDeleteSema(frame_sema);
+  thread_handle = frame_sema = -1;
+
+  if (wav_file)
+  {
+    fseek(wav_file, 0, SEEK_SET);
+    write_wav_header(wav_file, wav_bytes);
+  }
+
+  free_buffers();
+}
+
+int pl_capture_is_active()
+{
+  return capture_active;
+}
+
+int pl_capture_put_frame(const PspImage *image)
+{
+  PspImage *slot;
+  int y, w, h, bytes;
+
+  if (!capture_active || image->Depth != PSP_IMAGE_16BPP) return 0;
+
+  /* Drop frame if the encoder is behind */
+  if (frame_head - frame_tail >= (unsigned int)frame_slots)
+  {
+    frames_dropped++;
+    return 0;
+  }
+
+  slot = frames[frame_head % frame_slots];
+  w = (image->Viewport.Width > slot->Width) ? slot->Width : image->Viewport.Width;
+  h = (image->Viewport.Height > slot->Height) ? slot->Height : image->Viewport.Height;
+  bytes = image->BytesPerPixel;
+
+  for (y = 0; y < h; y++)
+    memcpy((unsigned char*)slot->Pixels + y * slot->Width * bytes,
+           (unsigned char*)image->Pixels + ((image->Viewport.Y + y)
+             * image->Width + image->Viewport.X) * bytes,
+           w * bytes);
+
+  slot->Viewport.X = slot->Viewport.Y = 0;
+  slot->Viewport.Width = w;
+  slot->Viewport.Height = h;
+
+  frame_head++;
+  sceKernelSignalSema(frame_sema, 1);
+
+  return 1;
+}
+
+void pl_capture_put_samples(const short *buffer,
+                            unsigned int count)
+{
+  unsigned int i, free_slots;
+
+  /* Flag the copy before checking capture_active, so that
+     pl_capture_stop() either waits for it or it sees the stop */
+  samples_busy = 1;
+  if (!capture_active || !sample_slots)
+  {
+    samples_busy = 0;
+    return;
+  }
+
+  /* Store as much as fits, count the rest as dropped */
+  free_slots = sample_slots - (sample_head - sample_tail);
+  if (count > free_slots)
+  {
+    samples_dropped += count - free_slots;
+    count = free_slots;
+  }
+
+  for (i = 0; i < count; i++)
+    samples[(sample_head + i) % sample_slots] = buffer[i];
+  sample_head += count;
+
+  samples_busy = 0;
+}
+
+unsigned int pl_capture_get_frames_dropped()
+{
+  return frames_dropped;
+}
+
+unsigned int pl_capture_get_samples_dropped()
+{
+  return samples_dropped;
+}
+
+static int capture_thread(int args, void *argp)
+{
+  pl_file_path frame_path;
+  SceUInt timeout;
+
+  for (;;)
+  {
+    /* Wake up for new frames, or periodically to write audio */
+    timeout = IDLE_DELAY_US;
+    sceKernelWaitSema(frame_sema, 1, &timeout);
+
+    flush_samples();
+
+    while (frame_tail != frame_head)
+    {
+      snprintf(frame_path, sizeof(frame_path) - 1, "%s-%06u.png",
+        capture_path, frames_written++);
+      pspImageSavePng(frame_path, frames[frame_tail % frame_slots]);
+      frame_tail++;
+
+      flush_samples();
+    }
+
+    if (capture_stop) break;
+  }
+
+  sceKernelExitThread(0);
+  return 0;
+}
+
+static void flush_samples()
+{
+  unsigned int head, start, count;
+
+  if (!wav_file) return;
+
+  /* Write queued samples in at most two contiguous runs */
+  for (head = sample_head; sample_tail != head; sample_tail += count)
+  {
+    start = sample_tail % sample_slots;
+    count = head - sample_tail;
+    if (start + count > sample_slots) count = sample_slots - start;
+
+    fwrite(samples + start, sizeof(short), count, wav_file);
+    wav_bytes += count * sizeof(short);
+  }
+}
+
+static void write_wav_header(FILE *file, unsigned int data_bytes)
+{
+  unsigned int chunk[11];
+
+  /* RIFF/WAVE, 16-bit mono PCM; PSP is little-endian */
+  memcpy(&chunk[0], "RIFF", 4);
+  chunk[1] = 36 + data_bytes;
+  memcpy(&chunk[2], "WAVE", 4);
+  memcpy(&chunk[3], "fmt ", 4);
+  chunk[4] = 16;
+  chunk[5] = 1 | (1 << 16);      /* PCM, 1 channel */
+  chunk[6] = sample_rate;
+  chunk[7] = sample_rate * sizeof(short);
+  chunk[8] = sizeof(short) | (16 << 16); /* Block align, bits/sample */
+  memcpy(&chunk[9], "data", 4);
+  chunk[10] = data_bytes;
+
+  fwrite(chunk, sizeof(chunk), 1, file);
+}
+
+static void free_buffers()
+{
+  int i;
+
+  if (frames)
+  {
+    for (i = 0; i < frame_slots; i++)
+      if (frames[i]) pspImageDestroy(frames[i]);
+    free(frames);
+    frames = NULL;
+  }
+
+  if (samples)
+  {
+    free(samples);
+    samples = NULL;
+  }
+
+  if (wav_file)
+  {
+    fclose(wav_file);
+    wav_file = NULL;
+  }
+}
@@ -0,0 +1,55 @@
+/* psplib/pl_capture.h: Background frame and audio capture
+   Copyright (C) 2007-2009 Akop Karapetyan
+
+   $Id$
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Author contact information: 
+     Email: dev@psp.akop.org
+*/
+
+
+#ifndef _PL_CAPTURE_H
+#define _PL_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "image.h"
+
+/* Frames and samples are queued without blocking and written */
+/* out by a low-priority thread; when a queue is full, data    */
+/* is dropped and counted instead                              */
+
+int  pl_capture_start(const char *path,
+                      const char *prefix,
+                      int max_width,
+                      int max_height,
+                      int frame_slots,
+                      int sample_rate);
+void pl_capture_stop();
+int  pl_capture_is_active();
+int  pl_capture_put_frame(const PspImage *image);
+void pl_capture_put_samples(const short *samples,
+                            unsigned int count);
+unsigned int pl_capture_get_frames_dropped();
+unsigned int pl_capture_get_samples_dropped();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PL_CAPTURE_H
@@ -24,6 +24,7 @@
 #include <pspkernel.h>
 #include <pspgu.h>
 #include <math.h>
+#include <string.h>
 
 #include "image.h"
 
@@ -55,6 +56,11 @@ static void *_disp_buffer    = NULL;
 static void *_draw_buffer    = NULL;
 static void *_depth_buffer   = NULL;
 static unsigned int _format  = 0;
+static int _filter           = GU_LINEAR;
+
+/* 4x2 texture: clear row, then black row (alpha set per draw) */
+static unsigned int __attribute__((aligned(16))) _scanline_tex[8] =
+  { 0, 0, 0, 0, 0xff000000, 0xff000000, 0xff000000, 0xff000000 };
 
 static unsigned int __attribute__((aligned(16))) _disp_list[262144];
 
@@ -143,7 +149,19 @@ void pl_gfx_put_image(const PspImage *image, int dx, int dy, int dw, int dh)
   int scissor_enabled = sceGuGetStatus(GU_SCISSOR_TEST);
   int texture_enabled = sceGuGetStatus(GU_TEXTURE_2D);
 
-  sceKernelDcacheWritebackAll();
+  /* Write back only the rows being drawn; uncached (VRAM) */
+  /* frame buffers are sampled as-is with no CPU copy      */
+  if (!((unsigned int)image->Pixels & 0x40000000))
+  {
+    int stride = image->Width * image->BytesPerPixel;
+    int rows = image->Viewport.Height;
+    if (image->Viewport.Y + rows < image->Height) rows++;
+    sceKernelDcacheWritebackRange((unsigned char*)image->Pixels
+      + image->Viewport.Y * stride, rows * stride);
+  }
+  if (image->Depth == PSP_IMAGE_INDEXED)
+    sceKernelDcacheWritebackRange(image->Palette,
+      image->PalSize * sizeof(unsigned short));
 
   if (scissor_enabled) sceGuDisable(GU_SCISSOR_TEST);
   if (!texture_enabled) sceGuEnable(GU_TEXTURE_2D);
@@ -158,7 +176,7 @@ void pl_gfx_put_image(const PspImage *image, int dx, int dy, int dw, int dh)
   sceGuTexImage(0, image->Width, image->Width, image->Width, image->Pixels);
 
   sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGBA);
-  sceGuTexFilter(GU_LINEAR, GU_LINEAR);
+  sceGuTexFilter(_filter, _filter);
 
   float sc_end, slsz_scaled, ddx = (float)dx;
   short start, end, sxr;
@@ -223,3 +241,108 @@ void pl_gfx_swap()
 {
   sceGuSwapBuffers();
 }
+
+void pl_gfx_set_filter(int filter)
+{
+  _filter = (filter == PL_GFX_FILTER_NEAREST) ? GU_NEAREST : GU_LINEAR;
+}
+
+void pl_gfx_put_scanlines(int dx, int dy, int dw, int dh, unsigned char alpha)
+{
+  int scissor_enabled = sceGuGetStatus(GU_SCISSOR_TEST);
+  int texture_enabled = sceGuGetStatus(GU_TEXTURE_2D);
+
+  sceKernelDcacheWritebackRange(_scanline_tex, sizeof(_scanline_tex));
+
+  if (scissor_enabled) sceGuDisable(GU_SCISSOR_TEST);
+  if (!texture_enabled) sceGuEnable(GU_TEXTURE_2D);
+
+  sceGuTexMode(GU_PSM_8888, 0, 0, GU_FALSE);
+  sceGuTexImage(0, 4, 2, 4, _scanline_tex);
+  sceGuTexWrap(GU_REPEAT, GU_REPEAT);
+  sceGuTexFunc(GU_TFX_MODULATE, GU_TCC_RGBA);
+  sceGuTexFilter(GU_NEAREST, GU_NEAREST);
+
+  /* One texel per destination pixel, so every other output line */
+  /* is darkened regardless of scaling                           */
+  pl_gfx_vertex *vert = (pl_gfx_vertex*)sceGuGetMemory(2 * sizeof(pl_gfx_vertex));
+
+  vert[0].u = 0;  vert[0].v = 0;
+  vert[1].u = dw; vert[1].v = dh;
+  vert[0].x = dx; vert[0].y = dy;
+  vert[1].x = dx + dw; vert[1].y = dy + dh;
+  vert[0].color = vert[1].color = 0x0fff | ((alpha >> 4) << 12);
+  vert[0].z = vert[1].z = 0;
+
+  sceGuDrawArray(GU_SPRITES, GU_TEXTURE_16BIT | GU_COLOR_4444 |
+                             GU_VERTEX_16BIT | GU_TRANSFORM_2D,
+                 2, 0, vert);
+
+  /* Restore states */
+  if (!texture_enabled) sceGuDisable(GU_TEXTURE_2D);
+  if (scissor_enabled) sceGuEnable(GU_SCISSOR_TEST);
+}
+
+int pl_gfx_scale2x(const PspImage *src, PspImage *dst)
+{
+  /* Source rows are copied to cached buffers once, with one */
+  /* pixel of padding on either side                         */
+  static u16 rows[3][BUF_WIDTH + 2];
+  int x, y, w, h;
+  u16 *prev, *curr, *next, *tmp, *d0, *d1;
+  const u16 *sp;
+  u16 B, D, E, F, H;
+
+  w = src->Viewport.Width;
+  h = src->Viewport.Height;
+
+  if (src->Depth != PSP_IMAGE_16BPP || dst->Depth != PSP_IMAGE_16BPP
+      || w > BUF_WIDTH || w * 2 > dst->Width || h * 2 > dst->Height)
+    return 0;
+
+  sp = (const u16*)src->Pixels + src->Viewport.Y * src->Width + src->Viewport.X;
+
+#define LOAD_ROW(row, ptr) \
+  memcpy((row), (ptr), w * sizeof(u16)); \
+  (row)[-1] = (row)[0]; (row)[w] = (row)[w - 1]
+
+  prev = rows[0] + 1;
+  curr = rows[1] + 1;
+  next = rows[2] + 1;
+
+  LOAD_ROW(curr, sp);
+  memcpy(prev - 1, curr - 1, (w + 2) * sizeof(u16));
+
+  for (y = 0; y < h; y++)
+  {
+    if (y + 1 < h) { LOAD_ROW(next, sp + (y + 1) * src->Width); }
+    else memcpy(next - 1, curr - 1, (w + 2) * sizeof(u16));
+
+    d0 = (u16*)dst->Pixels + (y * 2) * dst->Width;
+    d1 = d0 + dst->Width;
+
+    for (x = 0; x < w; x++, d0 += 2, d1 += 2)
+    {
+      B = prev[x]; H = next[x];
+      D = curr[x - 1]; E = curr[x]; F = curr[x + 1];
+
+      if (B != H && D != F)
+      {
+        d0[0] = (D == B) ? D : E;
+        d0[1] = (B == F) ? F : E;
+        d1[0] = (D == H) ? D : E;
+        d1[1] = (H == F) ? F : E;
+      }
+      else d0[0] = d0[1] = d1[0] = d1[1] = E;
+    }
+
+    tmp = prev; prev = curr; curr = next; next = tmp;
+  }
+#undef LOAD_ROW
+
+  dst->Viewport.X = dst->Viewport.Y = 0;
+  dst->Viewport.Width = w * 2;
+  dst->Viewport.Height = h * 2;
+
+  return 1;
+}
@@ -30,6 +30,9 @@ extern "C" {
 #define PL_GFX_SCREEN_WIDTH  480
 #define PL_GFX_SCREEN_HEIGHT 272
 
+#define PL_GFX_FILTER_NEAREST 0
+#define PL_GFX_FILTER_LINEAR  1
+
 int  pl_gfx_init();
 void pl_gfx_shutdown();
 
@@ -40,6 +43,9 @@ void pl_gfx_swap();
 
 void* pl_gfx_vram_alloc(unsigned int bytes);
 void  pl_gfx_put_image(const PspImage *image, int dx, int dy, int dw, int dh);
+void  pl_gfx_set_filter(int filter);
+void  pl_gfx_put_scanlines(int dx, int dy, int dw, int dh, unsigned char alpha);
+int   pl_gfx_scale2x(const PspImage *src, PspImage *dst);
 
 #ifdef __cplusplus
 }
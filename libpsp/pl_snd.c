@@ -30,20 +30,32 @@
 
 #define AUDIO_CHANNELS  1
 #define DEFAULT_SAMPLES 512
+#define DEFAULT_BUFFERS 2
 #define VOLUME_MAX      0x8000
 
 static int sound_ready;
 static volatile int sound_stop;
 
 typedef struct {
-  int thread_handle;
+  int thread_handle;   /* Fills free buffers using the callback */
+  int output_handle;   /* Hands filled buffers to the hardware */
+  int free_sema;
+  int filled_sema;
+  int lock_sema;       /* Held by the fill thread around the callback */
   int sound_ch_handle;
   int left_vol;
   int right_vol;
   pl_snd_callback callback;
   void *user_data;
-  short *sample_buffer[2];
-  unsigned int samples[2];
+  short *sample_buffer[PL_SND_MAX_BUFFERS];
+  unsigned int buffers;
+  unsigned int samples;
+  volatile unsigned int position;
+  volatile unsigned int underruns;
+  volatile unsigned int callbacks;
+  volatile unsigned int callback_us;
+  volatile unsigned int callback_max_us;
+  volatile unsigned int blocked_us;
   unsigned char paused;
   unsigned char stereo;
 } pl_snd_channel_info;
@@ -51,11 +63,20 @@ typedef struct {
 static pl_snd_channel_info sound_stream[AUDIO_CHANNELS];
 
 static int channel_thread(int args, void *argp);
+static int output_thread(int args, void *argp);
+static void stop_threads();
 static void free_buffers();
 static unsigned int get_bytes_per_sample(int channel);
 
 int pl_snd_init(int sample_count,
                 int stereo)
+{
+  return pl_snd_init_ex(sample_count, DEFAULT_BUFFERS, stereo);
+}
+
+int pl_snd_init_ex(int sample_count,
+                   int buffer_count,
+                   int stereo)
 {
   int i, j, failed;
   sound_stop = 0;
@@ -65,31 +86,41 @@ int pl_snd_init(int sample_count,
   if (sample_count <= 0) sample_count = DEFAULT_SAMPLES;
   sample_count = PSP_AUDIO_SAMPLE_ALIGN(sample_count);
 
+  /* Check buffer count */
+  if (buffer_count < PL_SND_MIN_BUFFERS) buffer_count = PL_SND_MIN_BUFFERS;
+  if (buffer_count > PL_SND_MAX_BUFFERS) buffer_count = PL_SND_MAX_BUFFERS;
+
   pl_snd_channel_info *ch_info;
   for (i = 0; i < AUDIO_CHANNELS; i++)
   {
     ch_info = &sound_stream[i];
     ch_info->sound_ch_handle = -1;
     ch_info->thread_handle = -1;
+    ch_info->output_handle = -1;
+    ch_info->free_sema = -1;
+    ch_info->filled_sema = -1;
+    ch_info->lock_sema = -1;
     ch_info->left_vol = VOLUME_MAX;
     ch_info->right_vol = VOLUME_MAX;
     ch_info->callback = NULL;
     ch_info->user_data = NULL;
     ch_info->paused = 1;
     ch_info->stereo = stereo;
+    ch_info->position = 0;
+    ch_info->underruns = 0;
+    ch_info->buffers = buffer_count;
+    ch_info->samples = sample_count;
+    pl_snd_reset_stats(i);
 
-    for (j = 0; j < 2; j++)
-    {
+    for (j = 0; j < PL_SND_MAX_BUFFERS; j++)
       ch_info->sample_buffer[j] = NULL;
-      ch_info->samples[j] = 0;
-    }
   }
 
   /* Initialize buffers */
   for (i = 0; i < AUDIO_CHANNELS; i++)
   {
     ch_info = &sound_stream[i];
-    for (j = 0; j < 2; j++)
+    for (j = 0; j < buffer_count; j++)
     {
       if (!(ch_info->sample_buffer[j] = 
               (short*)malloc(sample_count * get_bytes_per_sample(i))))
@@ -97,8 +128,6 @@ int pl_snd_init(int sample_count,
         free_buffers();
         return 0;
       }
-
-      ch_info->samples[j] = sample_count;
     }
   }
 
@@ -137,23 +166,61 @@ int pl_snd_init(int sample_count,
   sound_ready = 1;
 
   char label[16];
-  strcpy(label, "audiotX");
 
   for (i = 0; i < AUDIO_CHANNELS; i++)
   {
+    ch_info = &sound_stream[i];
+
+    /* All buffers start out free; none are waiting to be played */
+    strcpy(label, "audiofX");
+    label[6] = '0' + i;
+    ch_info->free_sema = sceKernelCreateSema(label, 0, buffer_count,
+      buffer_count, NULL);
+    strcpy(label, "audiopX");
+    label[6] = '0' + i;
+    ch_info->filled_sema = sceKernelCreateSema(label, 0, 0,
+      buffer_count, NULL);
+    strcpy(label, "audiolX");
     label[6] = '0' + i;
-    sound_stream[i].thread_handle = 
+    ch_info->lock_sema = sceKernelCreateSema(label, 0, 1, 1, NULL);
+
+    if (ch_info->free_sema < 0 || ch_info->filled_sema < 0
+      || ch_info->lock_sema < 0)
+    {
+      failed = 1;
+      break;
+    }
+
+    /* Output thread runs at a higher priority, so that a filled
+       buffer is queued as soon as the hardware can take it */
+    strcpy(label, "audiooX");
+    label[6] = '0' + i;
+    ch_info->output_handle = 
+      sceKernelCreateThread(label, (void*)&output_thread, 0x11, 0x1000, 
+        0, NULL);
+
+    if (ch_info->output_handle < 0)
+    {
+      ch_info->output_handle = -1;
+      failed = 1;
+      break;
+    }
+
+    strcpy(label, "audiotX");
+    label[6] = '0' + i;
+    ch_info->thread_handle = 
       sceKernelCreateThread(label, (void*)&channel_thread, 0x12, 0x10000, 
         0, NULL);
 
-    if (sound_stream[i].thread_handle < 0)
+    if (ch_info->thread_handle < 0)
     {
-      sound_stream[i].thread_handle = -1;
+      ch_info->thread_handle = -1;
       failed = 1;
       break;
     }
 
-    if (sceKernelStartThread(sound_stream[i].thread_handle, sizeof(i), &i) != 0)
+    if (sceKernelStartThread(ch_info->output_handle, sizeof(i), &i) != 0
+      || sceKernelStartThread(ch_info->thread_handle, sizeof(i), &i) != 0)
     {
       failed = 1;
       break;
@@ -162,19 +229,8 @@ int pl_snd_init(int sample_count,
 
   if (failed)
   {
-    sound_stop = 1;
-    for (i = 0; i < AUDIO_CHANNELS; i++)
-    {
-      if (sound_stream[i].thread_handle != -1)
-      {
-        //sceKernelWaitThreadEnd(sound_stream[i].threadhandle,NULL);
-        sceKernelDeleteThread(sound_stream[i].thread_handle);
-      }
-
-      sound_stream[i].thread_handle = -1;
-    }
-
     sound_ready = 0;
+    stop_threads();
     free_buffers();
     return 0;
   }
@@ -185,19 +241,10 @@ int pl_snd_init(int sample_count,
 void pl_snd_shutdown()
 {
   int i;
+  if (!sound_ready) return;
   sound_ready = 0;
-  sound_stop = 1;
-
-  for (i = 0; i < AUDIO_CHANNELS; i++)
-  {
-    if (sound_stream[i].thread_handle != -1)
-    {
-      //sceKernelWaitThreadEnd(sound_stream[i].threadhandle,NULL);
-      sceKernelDeleteThread(sound_stream[i].thread_handle);
-    }
 
-    sound_stream[i].thread_handle = -1;
-  }
+  stop_threads();
 
   for (i = 0; i < AUDIO_CHANNELS; i++)
   {
@@ -211,6 +258,59 @@ void pl_snd_shutdown()
   free_buffers();
 }
 
+static void stop_threads()
+{
+  int i;
+  SceUInt timeout;
+  pl_snd_channel_info *ch_info;
+  sound_stop = 1;
+
+  for (i = 0; i < AUDIO_CHANNELS; i++)
+  {
+    ch_info = &sound_stream[i];
+
+    /* Wake up both threads, so that they notice sound_stop */
+    if (ch_info->free_sema >= 0)
+      sceKernelSignalSema(ch_info->free_sema, 1);
+    if (ch_info->filled_sema >= 0)
+      sceKernelSignalSema(ch_info->filled_sema, 1);
+
+    if (ch_info->thread_handle != -1)
+    {
+      timeout = 1000000;
+      sceKernelWaitThreadEnd(ch_info->thread_handle, &timeout);
+      sceKernelDeleteThread(ch_info->thread_handle);
+      ch_info->thread_handle = -1;
+    }
+
+    if (ch_info->output_handle != -1)
+    {
+      timeout = 1000000;
+      sceKernelWaitThreadEnd(ch_info->output_handle, &timeout);
+      sceKernelDeleteThread(ch_info->output_handle);
+      ch_info->output_handle = -1;
+    }
+
+    if (ch_info->free_sema >= 0)
+    {
+      sceKernelDeleteSema(ch_info->free_sema);
+      ch_info->free_sema = -1;
+    }
+
+    if (ch_info->filled_sema >= 0)
+    {
+      sceKernelDeleteSema(ch_info->filled_sema);
+      ch_info->filled_sema = -1;
+    }
+
+    if (ch_info->lock_sema >= 0)
+    {
+      sceKernelDeleteSema(ch_info->lock_sema);
+      ch_info->lock_sema = -1;
+    }
+  }
+}
+
 static inline int play_blocking(unsigned int channel,
                                 unsigned int vol1,
                                 unsigned int vol2,
@@ -225,30 +325,45 @@ static inline int play_blocking(unsigned int channel,
 
 static int channel_thread(int args, void *argp)
 {
-  volatile int bufidx = 0;
+  unsigned int bufidx = 0;
   int channel = *(int*)argp;
-  int i, j;
+  int i;
   unsigned short *ptr_m;
   unsigned int *ptr_s;
   void *bufptr;
-  unsigned int samples;
+  unsigned int samples, start, now, elapsed;
   pl_snd_callback callback;
   pl_snd_channel_info *ch_info;
 
   ch_info = &sound_stream[channel];
-  for (j = 0; j < 2; j++)
-    memset(ch_info->sample_buffer[j], 0,
-           ch_info->samples[j] * get_bytes_per_sample(channel));
+  samples = ch_info->samples;
 
   while (!sound_stop)
   {
+    /* Wait for the output thread to give back a played buffer */
+    start = sceKernelGetSystemTimeLow();
+    if (sceKernelWaitSema(ch_info->free_sema, 1, NULL) < 0 || sound_stop)
+      break;
+
+    /* pl_snd_pause() takes the lock to wait out a running callback */
+    sceKernelWaitSema(ch_info->lock_sema, 1, NULL);
+    now = sceKernelGetSystemTimeLow();
+    ch_info->blocked_us += now - start;
+
     callback = ch_info->callback;
     bufptr = ch_info->sample_buffer[bufidx];
-    samples = ch_info->samples[bufidx];
 
     if (callback && !ch_info->paused)
+    {
       /* Use callback to fill buffer */
       callback(bufptr, samples, ch_info->user_data);
+
+      elapsed = sceKernelGetSystemTimeLow() - now;
+      ch_info->callback_us += elapsed;
+      if (elapsed > ch_info->callback_max_us)
+        ch_info->callback_max_us = elapsed;
+      ch_info->callbacks++;
+    }
     else
     {
       /* Fill buffer with silence */
@@ -258,14 +373,53 @@ static int channel_thread(int args, void *argp)
         for (i = 0, ptr_m = bufptr; i < samples; i++) *(ptr_m++) = 0;
     }
 
-    /* Play sound */
-	  play_blocking(channel,
+    sceKernelSignalSema(ch_info->lock_sema, 1);
+
+    /* Queue buffer for playback */
+    sceKernelSignalSema(ch_info->filled_sema, 1);
+
+    /* Switch active buffer */
+    bufidx = (bufidx + 1) % ch_info->buffers;
+  }
+
+  sceKernelExitThread(0);
+  return 0;
+}
+
+static int output_thread(int args, void *argp)
+{
+  unsigned int bufidx = 0;
+  int channel = *(int*)argp;
+  int queued = 0;
+  pl_snd_channel_info *ch_info;
+
+  ch_info = &sound_stream[channel];
+
+  while (!sound_stop)
+  {
+    /* Wait for the next filled buffer */
+    if (sceKernelWaitSema(ch_info->filled_sema, 1, NULL) < 0 || sound_stop)
+      break;
+
+    /* An empty hardware queue at this point means a gap in playback */
+    if (ch_info->position && !ch_info->paused
+      && sceAudioGetChannelRestLength(ch_info->sound_ch_handle) == 0)
+      ch_info->underruns++;
+
+    /* Play sound; returns once the previous buffer is done */
+    play_blocking(channel,
                   ch_info->left_vol,
                   ch_info->right_vol,
-                  bufptr);
+                  ch_info->sample_buffer[bufidx]);
+    ch_info->position += ch_info->samples;
+
+    /* The buffer queued before this one can now be refilled;
+       this one is still being read by the hardware */
+    if (queued) sceKernelSignalSema(ch_info->free_sema, 1);
+    queued = 1;
 
     /* Switch active buffer */
-    bufidx = (bufidx ? 0 : 1);
+    bufidx = (bufidx + 1) % ch_info->buffers;
   }
 
   sceKernelExitThread(0);
@@ -280,7 +434,7 @@ static void free_buffers()
   for (i = 0; i < AUDIO_CHANNELS; i++)
   {
     ch_info = &sound_stream[i];
-    for (j = 0; j < 2; j++)
+    for (j = 0; j < PL_SND_MAX_BUFFERS; j++)
     {
       if (ch_info->sample_buffer[j])
       {
@@ -334,11 +488,78 @@ static unsigned int get_bytes_per_sample(int channel)
     : sizeof(pl_snd_mono_sample);
 }
 
+unsigned int pl_snd_get_position(int channel)
+{
+  int rest;
+  unsigned int position;
+
+  if (channel < 0 || channel >= AUDIO_CHANNELS)
+    return 0;
+
+  /* Samples handed to the hardware, less those it has yet to
+     play, so the position moves smoothly within a buffer */
+  pl_snd_channel_info *ch_info = &sound_stream[channel];
+  position = ch_info->position;
+  if (sound_ready
+    && (rest = sceAudioGetChannelRestLength(ch_info->sound_ch_handle)) > 0
+    && rest < position)
+    position -= rest;
+
+  return position;
+}
+
+unsigned int pl_snd_get_underruns(int channel)
+{
+  if (channel < 0 || channel >= AUDIO_CHANNELS)
+    return 0;
+  return sound_stream[channel].underruns;
+}
+
+int pl_snd_get_stats(int channel,
+                     pl_snd_stats *stats)
+{
+  if (!sound_ready || channel < 0 || channel >= AUDIO_CHANNELS)
+    return 0;
+
+  pl_snd_channel_info *ch_info = &sound_stream[channel];
+  stats->buffers = ch_info->buffers;
+  stats->samples = ch_info->samples;
+  stats->callbacks = ch_info->callbacks;
+  stats->callback_us = ch_info->callback_us;
+  stats->callback_max_us = ch_info->callback_max_us;
+  stats->blocked_us = ch_info->blocked_us;
+  stats->underruns = ch_info->underruns;
+
+  return 1;
+}
+
+void pl_snd_reset_stats(int channel)
+{
+  if (channel < 0 || channel >= AUDIO_CHANNELS)
+    return;
+
+  pl_snd_channel_info *ch_info = &sound_stream[channel];
+  ch_info->callbacks = 0;
+  ch_info->callback_us = 0;
+  ch_info->callback_max_us = 0;
+  ch_info->blocked_us = 0;
+}
+
 int pl_snd_pause(int channel)
 {
-  if (channel < 0 || channel > AUDIO_CHANNELS)
+  if (channel < 0 || channel >= AUDIO_CHANNELS)
     return 0;
-  sound_stream[channel].paused = 1;
+  pl_snd_channel_info *ch_info = &sound_stream[channel];
+  ch_info->paused = 1;
+
+  /* The fill thread checks paused under the lock, so once we get
+     the lock no callback is running and none will start */
+  if (sound_ready && ch_info->lock_sema >= 0)
+  {
+    sceKernelWaitSema(ch_info->lock_sema, 1, NULL);
+    sceKernelSignalSema(ch_info->lock_sema, 1);
+  }
+
   return 1;
 }
 
@@ -30,6 +30,9 @@ extern "C" {
 #define PL_SND_ALIGN_SAMPLE(s) (((s) + 63) & ~63)
 #define PL_SND_TRUNCATE_SAMPLE(s) ((s) & ~63)
 
+#define PL_SND_MIN_BUFFERS 2
+#define PL_SND_MAX_BUFFERS 8
+
 typedef struct pl_snd_stereo_sample_t
 {
   short l;
@@ -47,21 +50,51 @@ typedef union pl_snd_sample_t
   pl_snd_mono_sample mono;
 } pl_snd_sample;
 
+/* Audio thread telemetry; times are in microseconds */
+typedef struct pl_snd_stats_t
+{
+  unsigned int buffers;         /* Buffers queued per channel */
+  unsigned int samples;         /* Samples per buffer */
+  unsigned int callbacks;       /* Buffers filled by the callback */
+  unsigned int callback_us;     /* Total time spent in the callback */
+  unsigned int callback_max_us; /* Longest single callback */
+  unsigned int blocked_us;      /* Time spent waiting for a free buffer */
+  unsigned int underruns;       /* Times the hardware ran out of samples */
+} pl_snd_stats;
+
 typedef void (*pl_snd_callback)(pl_snd_sample *buffer,
                                 unsigned int samples,
                                 void *user_data);
 
 int  pl_snd_init(int samples, 
                  int stereo);
+/* Same as pl_snd_init(), with a queue of buffers (clamped to
+   PL_SND_MIN_BUFFERS..PL_SND_MAX_BUFFERS) instead of two */
+int  pl_snd_init_ex(int samples,
+                    int buffers,
+                    int stereo);
 int  pl_snd_set_callback(int channel,
                          pl_snd_callback callback,
                          void *userdata);
+/* Returns once no callback is running on channel; none will be
+   called again until pl_snd_resume() */
 int  pl_snd_pause(int channel);
 int  pl_snd_resume(int channel);
 int  pl_snd_mute(int channel);
 int  pl_snd_unmute(int channel);
 void pl_snd_shutdown();
 
+/* Samples played on channel since pl_snd_init(), to within what
+   the hardware reports still queued (wraps around) */
+unsigned int pl_snd_get_position(int channel);
+/* Times the hardware ran out of samples to play on channel */
+unsigned int pl_snd_get_underruns(int channel);
+/* Copies telemetry for channel into stats; returns 0 if not playing */
+int  pl_snd_get_stats(int channel,
+                      pl_snd_stats *stats);
+/* Restarts the timing counters (underruns keep counting) */
+void pl_snd_reset_stats(int channel);
+
 #ifdef __cplusplus
 }
 #endif
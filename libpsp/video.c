@@ -58,6 +58,29 @@ struct TexVertex
   short x, y, z;
 };
 
+struct TextVertex
+{
+  unsigned short u, v;
+  u32 color;
+  short x, y, z;
+};
+
+/* Font rasterized into a T8 texture, one cell per character, */
+/* each cell including a 1-pixel outline around the glyph     */
+struct FontAtlas
+{
+  const PspFont *Font;
+  int CellW, CellH;
+  int TexW, TexH;
+  unsigned char *Texels;
+};
+
+#define FONT_ATLASES   4
+#define ATLAS_COLUMNS  16
+#define TEXEL_CLEAR    0
+#define TEXEL_GLYPH    1
+#define TEXEL_OUTLINE  2
+
 static u8 FrameIndex;
 static void *DisplayBuffer;
 static void *DrawBuffer;
@@ -70,9 +93,17 @@ static unsigned short __attribute__((aligned(16))) ScratchBuffer[BUF_WIDTH * SCR
 //static void *ScratchBuffer;
 //static int ScratchBufferSize;
 static unsigned int __attribute__((aligned(16))) List[262144]; /* TODO: ? */
+static struct FontAtlas FontAtlases[FONT_ATLASES];
+static int NextAtlas;
+/* Glyph texels take on the text color, outline texels are black */
+static u32 __attribute__((aligned(16))) FontClut[8] =
+  { 0x00000000, 0xffffffff, 0xff000000 };
 
 static void* GetBuffer(const PspImage *image);
-static inline int PutChar(const PspFont *font, int sx, int sy, unsigned char sym, int color);
+static void* GetTexture(const PspImage *image, int *tex_w, int *tex_h, int *buf_w);
+static const struct FontAtlas* GetFontAtlas(const PspFont *font);
+static void DrawText(const struct FontAtlas *atlas, struct TextVertex *vert, int count);
+static inline int PutChar(const struct FontAtlas *atlas, struct TextVertex **vert, int sx, int sy, unsigned char sym, u32 color);
 
 void pspVideoInit()
 {
@@ -192,6 +223,60 @@ void* GetBuffer(const PspImage *image)
   return ScratchBuffer;
 }
 
+/* Returns pixel data for the GPU to sample, texturing the image in */
+/* place if its row stride allows it, and writes back only the     */
+/* cached rows (and palette) that are about to be read             */
+void* GetTexture(const PspImage *image, int *tex_w, int *tex_h, int *buf_w)
+{
+  void *pixels;
+  int rows, bpp = image->BytesPerPixel;
+
+  if (image->PowerOfTwo)
+  {
+    pixels = image->Pixels;
+    *tex_w = *tex_h = *buf_w = image->Width;
+    rows = image->Viewport.Y + image->Viewport.Height;
+  }
+  else if (!((image->Width * bpp) & 15) && !((u32)image->Pixels & 15)
+    && image->Width <= 512 && image->Height <= 512)
+  {
+    /* Texture dimensions must be powers of two, but buffer width */
+    /* need only be 16-byte aligned; no copy necessary            */
+    pixels = image->Pixels;
+    for (*tex_w = 1; *tex_w < image->Width; *tex_w <<= 1);
+    for (*tex_h = 1; *tex_h < image->Height; *tex_h <<= 1);
+    *buf_w = image->Width;
+    rows = image->Viewport.Y + image->Viewport.Height;
+  }
+  else
+  {
+    pixels = GetBuffer(image);
+    *tex_w = *tex_h = *buf_w = BUF_WIDTH;
+    rows = image->Viewport.Height;
+    if (rows > SCR_HEIGHT) rows = SCR_HEIGHT;
+  }
+
+  /* Uncached (e.g. VRAM) images need no writeback */
+  if (!((u32)pixels & 0x40000000))
+  {
+    int first = (pixels == image->Pixels) ? image->Viewport.Y : 0;
+    int stride = *buf_w * bpp;
+
+    /* One more row for the bilinear filter, where available */
+    if (rows < ((pixels == image->Pixels) ? image->Height : SCR_HEIGHT))
+      rows++;
+
+    sceKernelDcacheWritebackRange((u8*)pixels + first * stride,
+      (rows - first) * stride);
+  }
+
+  if (image->Depth == PSP_IMAGE_INDEXED)
+    sceKernelDcacheWritebackRange(image->Palette,
+      image->PalSize * sizeof(unsigned short));
+
+  return pixels;
+}
+
 void pspVideoBeginList(void *list)
 {
   sceGuStart(GU_CALL, list);
@@ -208,25 +293,26 @@ void pspVideoEnd()
   sceGuSync(0, 0);
 }
 
+/* Close the display list without waiting for the GPU; */
+/* call pspVideoSync() before the next list or swap    */
+void pspVideoEndAsync()
+{
+  sceGuFinish();
+}
+
+void pspVideoSync()
+{
+  sceGuSync(0, 0);
+}
+
 void pspVideoPutImage(const PspImage *image, int dx, int dy, int dw, int dh)
 {
   sceGuScissor(dx, dy, dx + dw, dy + dh);
 
   void *pixels;
-  int width;
+  int width, tex_w, tex_h;
 
-  if (image->PowerOfTwo)
-  {
-    pixels = image->Pixels;
-    width = image->Width;
-  }
-  else
-  {
-    pixels = GetBuffer(image);
-    width = BUF_WIDTH;
-  }
-
-  sceKernelDcacheWritebackAll();
+  pixels = GetTexture(image, &tex_w, &tex_h, &width);
 /*
   if (image->Depth != PSP_IMAGE_INDEXED &&
     dw == image->Viewport.Width && dh == image->Viewport.Height)
@@ -249,7 +335,7 @@ void pspVideoPutImage(const PspImage *image, int dx, int dy, int dw, int dh)
     }
 
     sceGuTexMode(image->TextureFormat, 0, 0, GU_FALSE);
-    sceGuTexImage(0, width, width, width, pixels);
+    sceGuTexImage(0, tex_w, tex_h, width, pixels);
     sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGBA);
     sceGuTexFilter(GU_LINEAR, GU_LINEAR);
  
@@ -295,20 +381,9 @@ void pspVideoPutImageAlpha(const PspImage *image, int dx, int dy, int dw, int dh
   sceGuScissor(dx, dy, dx + dw, dy + dh);
 
   void *pixels;
-  int width;
-
-  if (image->PowerOfTwo)
-  {
-    pixels = image->Pixels;
-    width = image->Width;
-  }
-  else
-  {
-    pixels = GetBuffer(image);
-    width = BUF_WIDTH;
-  }
+  int width, tex_w, tex_h;
 
-  sceKernelDcacheWritebackAll();
+  pixels = GetTexture(image, &tex_w, &tex_h, &width);
 /*
   if (image->Depth != PSP_IMAGE_INDEXED &&
     dw == image->Viewport.Width && dh == image->Viewport.Height)
@@ -336,7 +411,7 @@ void pspVideoPutImageAlpha(const PspImage *image, int dx, int dy, int dw, int dh
     }
 
     sceGuTexMode(image->TextureFormat, 0, 0, GU_FALSE);
-    sceGuTexImage(0, width, width, width, pixels);
+    sceGuTexImage(0, tex_w, tex_h, width, pixels);
     sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGBA);
     sceGuTexFilter(GU_LINEAR, GU_LINEAR);
  
@@ -385,6 +460,11 @@ void pspVideoSwapBuffers()
 
 void pspVideoShutdown()
 {
+  int i;
+  for (i = 0; i < FONT_ATLASES; i++)
+    if (FontAtlases[i].Texels)
+      free(FontAtlases[i].Texels);
+
   sceGuTerm();
 }
 
@@ -464,61 +544,142 @@ void pspVideoClearScreen()
   sceGuClear(GU_COLOR_BUFFER_BIT);
 }
 
-inline int PutChar(const PspFont *font, int sx, int sy, unsigned char sym, int color)
+/* Returns the texture atlas for font, rasterizing it on first use */
+const struct FontAtlas* GetFontAtlas(const PspFont *font)
 {
-  /* Instead of a tab, skip 4 spaces */
-  if (sym == (u8)'\t')
-    return font->Chars[(int)' '].Width * 4;
+  struct FontAtlas *atlas;
+  int i, j, k, w, h, x, y;
+  unsigned short row;
+  unsigned char *cell;
+
+  for (i = 0; i < FONT_ATLASES; i++)
+    if (FontAtlases[i].Font == font)
+      return &FontAtlases[i];
+
+  /* Reuse the least recently built slot */
+  atlas = &FontAtlases[NextAtlas];
+  NextAtlas = (NextAtlas + 1) % FONT_ATLASES;
+  if (atlas->Texels) free(atlas->Texels);
 
-  /* This function should be rewritten to write directly to VRAM, probably */
-  int h, v, i, j, w, s;
-  w = font->Chars[(int)sym].Width;
+  atlas->Font = font;
   h = font->Height;
+  for (i = 0, w = 0; i < 256; i++)
+    if (font->Chars[i].Width > w) w = font->Chars[i].Width;
 
-  /* Allocate and clear enough memory to write the pixels of the char */
-  s = sizeof(PspVertex) * (w + 2) * (h + 2);
-  PspVertex *vert = (PspVertex*)sceGuGetMemory(s);
-  memset(vert, 0, s);
+  atlas->CellW = w + 2;
+  atlas->CellH = h + 2;
+  for (atlas->TexW = 16; atlas->TexW < ATLAS_COLUMNS * atlas->CellW; atlas->TexW <<= 1);
+  for (atlas->TexH = 16; atlas->TexH < (256 / ATLAS_COLUMNS) * atlas->CellH; atlas->TexH <<= 1);
 
-  unsigned short row;
-  int shift;
+  if (!(atlas->Texels = (unsigned char*)memalign(16, atlas->TexW * atlas->TexH)))
+  {
+    atlas->Font = NULL;
+    return NULL;
+  }
 
-  v = 0;
-  for (j = 0; j < w; j++)
-    if (font->Chars[(int)sym].Char[0] & (1 << (w - j)))
-    { vert[v].x = sx + j; vert[v].y = sy - 1; vert[v].color = 0xff000000; v++; }
+  memset(atlas->Texels, TEXEL_CLEAR, atlas->TexW * atlas->TexH);
 
-  /* Initialize pixel values */
-  for (i = 0; i < h; i++)
+  /* Same glyph and outline pixels as the per-pixel renderer used to */
+  /* emit; glyph pixels always win over outline pixels               */
+#define TEXEL(px, py) cell[((py) + 1) * atlas->TexW + (px) + 1]
+#define OUTLINE(px, py) \
+  if (TEXEL(px, py) != TEXEL_GLYPH) TEXEL(px, py) = TEXEL_OUTLINE
+  for (k = 0; k < 256; k++)
   {
-    for (j = 0; j < w; j++)
+    w = font->Chars[k].Width;
+    if (!w || !font->Chars[k].Char) continue;
+
+    cell = atlas->Texels
+      + (k / ATLAS_COLUMNS) * atlas->CellH * atlas->TexW
+      + (k % ATLAS_COLUMNS) * atlas->CellW;
+
+    for (y = 0; y < h; y++)
     {
-      row = font->Chars[(int)sym].Char[i];
-      shift = w - j;
+      row = font->Chars[k].Char[y];
+      for (x = 0; x < w; x++)
+        if (row & (1 << (w - x))) TEXEL(x, y) = TEXEL_GLYPH;
+    }
 
-      if (row & (1 << shift))
-      {
-        if (j == 0 || !(row & (1 << (shift + 1))))
-        { vert[v].x = sx + j - 1; vert[v].y = sy + i; vert[v].color = 0xff000000; v++; }
-        vert[v].x = sx + j; vert[v].y = sy + i; vert[v].color = color; v++;
-        vert[v].x = sx + j + 1; vert[v].y = sy + i; vert[v].color = 0xff000000; v++;
-      }
-      else if (i > 0 && i < h - 1)
+    for (x = 0; x < w; x++)
+    {
+      if (font->Chars[k].Char[0] & (1 << (w - x))) OUTLINE(x, -1);
+      if (font->Chars[k].Char[h - 1] & (1 << (w - x))) OUTLINE(x, h);
+    }
+
+    for (y = 0; y < h; y++)
+    {
+      row = font->Chars[k].Char[y];
+      for (x = 0; x < w; x++)
       {
-        if ((i > 0) && (font->Chars[(int)sym].Char[i - 1] & (1 << shift)))
-        { vert[v].x = sx + j; vert[v].y = sy + i; vert[v].color = 0xff000000; v++; }
-        else if ((i < h - 1) && (font->Chars[(int)sym].Char[i + 1] & (1 << shift)))
-        { vert[v].x = sx + j; vert[v].y = sy + i; vert[v].color = 0xff000000; v++; }
+        if (row & (1 << (w - x)))
+        {
+          OUTLINE(x - 1, y);
+          OUTLINE(x + 1, y);
+        }
+        else if (y > 0 && y < h - 1
+          && ((font->Chars[k].Char[y - 1] | font->Chars[k].Char[y + 1]) & (1 << (w - x))))
+          OUTLINE(x, y);
       }
     }
   }
+#undef OUTLINE
+#undef TEXEL
 
-  for (j = 0; j < w; j++)
-    if (font->Chars[(int)sym].Char[h - 1] & (1 << (w - j)))
-    { vert[v].x = sx + j; vert[v].y = sy + h; vert[v].color = 0xff000000; v++; }
+  sceKernelDcacheWritebackRange(atlas->Texels, atlas->TexW * atlas->TexH);
+  sceKernelDcacheWritebackRange(FontClut, sizeof(FontClut));
 
-  /* Render the char as a set of pixels */
-  sceGuDrawArray(GU_POINTS, GU_COLOR_8888|GU_VERTEX_16BIT|GU_TRANSFORM_2D, v, NULL, vert);
+  return atlas;
+}
+
+/* Draws a batch of character sprites emitted by PutChar() */
+void DrawText(const struct FontAtlas *atlas, struct TextVertex *vert, int count)
+{
+  if (count <= 0) return;
+
+  sceGuEnable(GU_TEXTURE_2D);
+
+  sceGuClutMode(GU_PSM_8888, 0, 0xff, 0);
+  sceGuClutLoad(1, FontClut);
+  sceGuTexMode(GU_PSM_T8, 0, 0, GU_FALSE);
+  sceGuTexImage(0, atlas->TexW, atlas->TexH, atlas->TexW, atlas->Texels);
+  sceGuTexFunc(GU_TFX_MODULATE, GU_TCC_RGBA);
+  sceGuTexFilter(GU_NEAREST, GU_NEAREST);
+
+  sceGuDrawArray(GU_SPRITES,
+    GU_TEXTURE_16BIT|GU_COLOR_8888|GU_VERTEX_16BIT|GU_TRANSFORM_2D,
+    count, NULL, vert);
+
+  sceGuDisable(GU_TEXTURE_2D);
+}
+
+/* Emits a sprite (two vertices) for the character at *vert, */
+/* advancing it; returns width of the character              */
+inline int PutChar(const struct FontAtlas *atlas, struct TextVertex **vert, int sx, int sy, unsigned char sym, u32 color)
+{
+  const PspFont *font = atlas->Font;
+  struct TextVertex *v = *vert;
+  int w;
+
+  /* Instead of a tab, skip 4 spaces */
+  if (sym == (u8)'\t')
+    return font->Chars[(int)' '].Width * 4;
+
+  if (!(w = font->Chars[(int)sym].Width))
+    return 0;
+
+  /* Cell includes the outline, one pixel on each side */
+  v[0].u = (sym % ATLAS_COLUMNS) * atlas->CellW;
+  v[0].v = (sym / ATLAS_COLUMNS) * atlas->CellH;
+  v[1].u = v[0].u + w + 2;
+  v[1].v = v[0].v + font->Height + 2;
+
+  v[0].x = sx - 1; v[0].y = sy - 1;
+  v[1].x = v[0].x + w + 2; v[1].y = v[0].y + font->Height + 2;
+
+  v[0].color = v[1].color = color;
+  v[0].z = v[1].z = 0;
+
+  *vert += 2;
 
   /* Return total width */
   return w;
@@ -537,6 +698,12 @@ int pspVideoPrintCenter(const PspFont *font, int sx, int sy, int dx, const char
   width = pspFontGetTextWidth(font, string);
   sx += (dx - sx) / 2 - width / 2;
 
+  const struct FontAtlas *atlas = GetFontAtlas(font);
+  if (!atlas) return 0;
+
+  struct TextVertex *vert, *first;
+  vert = first = (struct TextVertex*)sceGuGetMemory(2 * strlen(string) * sizeof(struct TextVertex));
+
   for (ch = (unsigned char*)string, width = 0, max = 0; *ch; ch++)
   {
     if (*ch < 32)
@@ -554,10 +721,12 @@ int pspVideoPrintCenter(const PspFont *font, int sx, int sy, int dx, const char
       }
     }
 
-    width += PutChar(font, sx + width, sy, (u8)(*ch), c);
+    width += PutChar(atlas, &vert, sx + width, sy, (u8)(*ch), c);
     if (width > max) max = width;
   }
 
+  DrawText(atlas, first, vert - first);
+
   return max;
 }
 
@@ -566,6 +735,12 @@ int pspVideoPrintN(const PspFont *font, int sx, int sy, const char *string, int
   const unsigned char *ch;
   int width, i, c = color, max;
 
+  const struct FontAtlas *atlas = GetFontAtlas(font);
+  if (!atlas) return 0;
+
+  struct TextVertex *vert, *first;
+  vert = first = (struct TextVertex*)sceGuGetMemory(2 * strlen(string) * sizeof(struct TextVertex));
+
   for (ch = (unsigned char*)string, width = 0, i = 0, max = 0; *ch && (count < 0 || i < count); ch++, i++)
   {
     if (*ch < 32)
@@ -583,10 +758,12 @@ int pspVideoPrintN(const PspFont *font, int sx, int sy, const char *string, int
       }
     }
 
-    width += PutChar(font, sx + width, sy, (u8)(*ch), c);
+    width += PutChar(atlas, &vert, sx + width, sy, (u8)(*ch), c);
     if (width > max) max = width;
   }
 
+  DrawText(atlas, first, vert - first);
+
   return max;
 }
 
@@ -83,6 +83,8 @@ void pspVideoSwapBuffers();
 
 void pspVideoBegin();
 void pspVideoEnd();
+void pspVideoEndAsync();
+void pspVideoSync();
 
 void pspVideoDrawLine(int sx, int sy, int dx, int dy, u32 color);
 void pspVideoDrawRect(int sx, int sy, int dx, int dy, u32 color);